@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "sim.h"
+
+/*
+	The command line, a thin wrapper of the runs of the simulator library (sim.h).
+	Usage:
+		sim cfg.txt memin.txt memout.txt regout.txt traceinst.txt traceunit.txt
+		sim -batch manifest.txt [workers]
+		sim -sweep cfg.txt memin.txt sweep.txt [workers]
+		sim -gen workload.txt memin.txt
+		sim -bench bench.txt table.txt [repeats]
+		sim -memfloat mem.txt floats.txt [legacy]
+		sim -floatmem floats.txt mem.txt [legacy]
+		sim -memconv mem.txt mem.bin (or mem.bin mem.txt)
+		sim -traceconv trace.bin trace.txt
+*/
+int main(int argc, char** argv) {
+	if (argc >= 3 && strcmp(argv[1], "-batch") == 0) {
+		runBatch(argv[2], argc >= 4 ? atoi(argv[3]) : 0);
+		return 0;
+	}
+	if (argc >= 5 && strcmp(argv[1], "-sweep") == 0) {
+		runSweep(argv[2], argv[3], argv[4], argc >= 6 ? atoi(argv[5]) : 0);
+		return 0;
+	}
+	if (argc >= 4 && strcmp(argv[1], "-gen") == 0) {
+		generateWorkloadFile(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc >= 4 && strcmp(argv[1], "-bench") == 0) {
+		runBenchmark(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 3);
+		return 0;
+	}
+	if (argc >= 4 && (strcmp(argv[1], "-memfloat") == 0 || strcmp(argv[1], "-floatmem") == 0)) {
+		convertMemFloats(argv[2], argv[3], strcmp(argv[1], "-floatmem") == 0, argc >= 5 && strcmp(argv[4], "legacy") == 0);
+		return 0;
+	}
+	if (argc >= 4 && strcmp(argv[1], "-memconv") == 0) {
+		convertMemImage(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc >= 4 && strcmp(argv[1], "-traceconv") == 0) {
+		convertTrace(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc < 7) {
+		printf("usage: %s cfg memin memout regout traceinst traceunit\n       %s -batch manifest [workers]\n       %s -sweep cfg memin sweep [workers]\n       %s -gen workload memin\n       %s -bench bench table [repeats]\n       %s -memfloat mem floats [legacy]\n       %s -floatmem floats mem [legacy]\n       %s -memconv mem.txt mem.bin (or mem.bin mem.txt)\n       %s -traceconv trace.bin trace.txt\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+		return 0;
+	}
+	runSimulation(argv + 1);
+
+	return 0;
+}
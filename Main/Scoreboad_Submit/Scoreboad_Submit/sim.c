@@ -1,1355 +1,5143 @@
-#include <string.h>
-#include <stdio.h>
-#include <stdbool.h>
-#include <stdlib.h>
-#include <ctype.h>
-#include <math.h>
-
-#define BUF_SIZE            1024
-
-#define OP_LD   0
-#define OP_ST   1
-#define OP_ADD  2
-#define OP_SUB  3
-#define OP_MULT 4
-#define OP_DIV  5
-#define OP_HALT 6
-
-
-#define MEM_LENGTH_SIM 4096
-#define MAX_LINE_LENGTH 500
-#define HALT_INST 0x06000000
-
-
-
-static char yes_no[2][4] = { "No", "Yes" };
-//static char yes_no[2][4] = {"Yes", "No"};
-static char units_names[6][4] = { "LD", "ST", "ADD", "SUB", "MUL", "DIV" };
-static char units_names_low[6][4] = { "ld", "st", "add", "sub", "mul", "div" };
-/*
-	Instruction structure
-	Any value is document by the comment above it
-*/
-typedef struct {
-	// Instruction
-	int inst;
-
-	// Clock cycle that issue of this instruction occured.
-	int issue;
-
-	// Clock cycle that read of this instruction occured.
-	int read;
-
-	// Clock cycle that execution of this instruction finished.
-	int exec;
-
-	// Clock cycle that write back of this instruction occured.
-	int write;
-
-	// Instruction opcode
-	int opcode;
-
-	// Instruction destination
-	int dst;
-
-	// Instruction source 0
-	int src0;
-
-	// Instruction source 1
-	int src1;
-
-	// Instruction immidiate
-	int imm;
-
-	// Instruction handkng unit index
-	int unit_index;
-
-} Inst;
-
-/*
-	Function unit structure.
-	Any value is documented by te comment above
-*/
-typedef struct {
-	// 0 for non-busy, 1 for busy
-	int busy;
-
-	// register index for dest
-	int f_i;
-
-	// register index for src0
-	int f_j;
-
-	// register index for src1
-	int f_k;
-
-	// which type function unit works on src0.
-	int q_j_type;
-
-	// which index of function unit works on src0.
-	int q_j_idx;
-
-	// which type function unit works on src0.
-	int q_k_type;
-
-	// which index of function unit works on src0.
-	int q_k_idx;
-
-	// 0 for no, 1 for yes.
-	int r_j;
-
-	// 0 for no, 1 for yes.
-	int r_k;
-
-	// type of the function unit
-	int type;
-
-	// the number of clock cycle for this unit to finish
-	int delay;
-
-	// the number of remaining clock cycle for this unit to finish.
-	int remain;
-
-	// unit index number.
-	int index;
-
-	// unit result value.
-	float result;
-
-	// the instruction this unit in handle
-	Inst *inst_ptr;
-
-	// the instruction index that this unit in handle
-	int inst_idx;
-
-	// Flag indicates this unit invloves in WAW
-	int waw_flag;
-} Unit;
-
-
-/*
-	array - Array of units structures
-	used - number of unit in the array
-	size - number of allocated units to the array
-*/
-typedef struct
-{
-	Unit *array;
-	size_t used;
-	size_t size;
-} Unit_arr;
-
-
-/*
-	The following functions get the insturction value as int and parse data from it
-	Each function parse diferent value by its name
-*/
-unsigned int parserOpcode(unsigned int inst) {
-	unsigned int opcode;
-	opcode = inst >> 24;
-	return opcode;
-}
-unsigned int parserDst(unsigned int inst) {
-	unsigned int dst;
-	inst <<= 8;
-	dst = inst >> 28;
-	return dst;
-}
-unsigned int parserSrc0(unsigned int inst) {
-	unsigned int src0;
-	inst <<= 12;
-	src0 = inst >> 28;
-	return src0;
-}
-unsigned int parserSrc1(unsigned int inst) {
-	unsigned int src1;
-	inst <<= 16;
-	src1 = inst >> 28;
-	return src1;
-}
-unsigned int parserImm(unsigned int inst) {
-	unsigned int imm;
-	imm = inst & 0xFFF;
-	return imm;
-}
-
-//Gets a unit element and initialize its values intial values.
-void init_unit(Unit *element)
-{
-	element->busy = 0;
-	element->delay = -1;
-	element->f_i = -1;
-	element->f_j = -1;
-	element->f_k = -1;
-	element->index = -1;
-	element->q_j_idx = -1;
-	element->q_j_type = -1;
-	element->q_k_idx = -1;
-	element->q_k_type = -1;
-	element->remain = -1;
-	element->r_j = 1;
-	element->r_k = 1;
-	element->type = -1;
-	element->result = -1;
-	element->inst_idx = -1;
-	element->inst_ptr = NULL;
-	element->waw_flag = 0;
-}
-
-//Gets a unit element and resets its value. (f's, r's, q's, remain, instruction...)
-void reset_unit(Unit *element)
-{
-	element->busy = 0;
-	element->f_i = -1;
-	element->f_j = -1;
-	element->f_k = -1;
-	element->q_j_idx = -1;
-	element->q_j_type = -1;
-	element->q_k_idx = -1;
-	element->q_k_type = -1;
-	element->remain = -1;
-	element->r_j = 1;
-	element->r_k = 1;
-	element->result = -1;
-	element->inst_idx = -1;
-	element->inst_ptr = NULL;
-	element->waw_flag = 0;
-
-}
-
-// Creates any empty instruction object
-Inst init_inst()
-{
-	Inst inst;
-	inst.inst = 0;
-	inst.exec = -1;
-	inst.issue = -1;
-	inst.read = -1;
-	inst.write = -1;
-	inst.opcode = -1;
-	inst.dst = -1;
-	inst.src0 = -1;
-	inst.src1 = -1;
-	inst.imm = -1;
-	inst.unit_index = -1;
-
-	return inst;
-}
-
-// Creates a full instruction element by the parsed data from the input value of the instruction.
-Inst createInst(int inst) {
-	Inst i = init_inst();
-	i.inst = inst;
-	i.opcode = parserOpcode(inst);
-
-	i.dst = parserDst(inst);
-	i.src0 = parserSrc0(inst);
-	i.src1 = parserSrc1(inst);
-	i.imm = parserImm(inst);
-
-	return i;
-}
-
-// Initializing an empty Unit_arr if size initialSize
-void init_unit_array(Unit_arr *a, size_t initialSize)
-{
-	// Allocate initial space
-	a->array = (Unit*)malloc(initialSize * sizeof(Unit));
-
-	a->used = 0;
-	a->size = initialSize;
-	for (unsigned int i = 0; i < initialSize; i++)
-	{
-		memset(&a->array[i], 0, sizeof(Unit));
-	}
-}
-
-// Free the memory of the Unit_arr
-void free_unit_array(Unit_arr *a)
-{
-	// Now free the array 
-	free(a->array);
-	a->array = NULL;
-	a->used = 0;
-	a->size = 0;
-}
-
-
-// Inserts new Unit into the Unit_arr, If the array is full its realloactes twice its memory.
-void insert_unit_array(Unit_arr *a, Unit element)
-{
-	if (a->used == a->size)
-	{
-		a->size *= 2;
-		a->array = (Unit *)realloc(a->array, a->size * sizeof(Unit));
-	}
-	// Copy element fields.
-	a->array[a->used].busy = element.busy;
-	a->array[a->used].delay = element.delay;
-	a->array[a->used].f_i = element.f_i;
-	a->array[a->used].f_j = element.f_j;
-	a->array[a->used].f_k = element.f_k;
-	a->array[a->used].index = element.index;
-	a->array[a->used].q_j_idx = element.q_j_idx;
-	a->array[a->used].q_j_type = element.q_j_type;
-	a->array[a->used].q_k_idx = element.q_k_idx;
-	a->array[a->used].q_k_type = element.q_k_type;
-	a->array[a->used].inst_ptr = element.inst_ptr;
-	a->array[a->used].inst_idx = element.inst_idx;
-	a->array[a->used].remain = element.remain;
-	a->array[a->used].r_j = element.r_j;
-	a->array[a->used].r_k = element.r_k;
-	a->array[a->used].type = element.type;
-	a->array[a->used].result = element.result;
-
-	a->used++;
-}
-
-
-// Get a value of single precision as 32 bit long and converts it to float
-float single_pre_to_float(unsigned long sp) {
-	unsigned long sign, exp, fra_bits, fra_b;
-	int i = 0;
-	float res, fra = 1.0;
-	if (sp == 0) {
-		return 0.0;
-	}
-	sign = sp >> 31;
-	exp = sp << 1 >> 24;
-	fra_bits = sp << 9 >> 9;
-	for (i = 0; i < 23; i++) {
-		fra_b = fra_bits << (i + 9);
-		fra_b = fra_b >> 31;
-		fra += fra_b * powf(2, -1 * (i + 1));
-	}
-	res = powf(-1, sign) * powf(2, exp - 127) * fra;
-
-	return res;
-}
-
-// Get a value of float and converts it to single precision as 32 bit int
-int floatToSinglePre(float f) {
-	int sign, exp, fra, exp_bit_len, i = 0, fra_to_bit = 0;
-	int integer = (int)floor(f);
-	int res;
-	float rat = f - integer;
-	sign = f > 0.0 ? 0 : 1;
-	exp_bit_len = floor(log2(integer));
-	exp = exp_bit_len + 127;
-	fra = integer << (23 - exp_bit_len);
-	for (i = 0; i < (23 - exp_bit_len); i++) {
-		rat = rat * 2;
-		if (1 > rat) {
-			fra_to_bit <<= 1;
-		}
-		else {
-			fra_to_bit += 1;
-			fra_to_bit <<= 1;
-			rat -= 1;
-		}
-	}
-	fra_to_bit >>= 1;
-	fra = fra | fra_to_bit;
-	fra = fra & 0x7FFFFF;
-	res = (((sign << 8) + exp) << 23) + fra;
-
-	return res;
-}
-/*
-	Get the configuration text file path and opens it, parsing from it the units details for the input type.
-	At the end the fu array is fulled with units according to the configuration file.
-*/
-int init_units(char* cfg_path, Unit_arr * fu, int type) {
-	int units = -1, delay = -1, i;
-	char units_str[20];
-	char delay_str[20];
-	char *ret;
-	FILE* config;
-	char config_buf[BUF_SIZE];
-	char unit_name[7];
-	Unit u;
-	Unit *u_ptr = &u;
-
-	// parsing the text to search inside the file
-	strcpy(units_str, units_names_low[type]);
-	strcat(units_str, "_nr_units");
-	strcpy(delay_str, units_names_low[type]);
-	strcat(delay_str, "_delay");
-
-	config = fopen(cfg_path, "r");
-	if (config == NULL) {
-		printf("couldn't open the config file");
-		return 0;
-	}
-
-	while (fgets(config_buf, BUF_SIZE, config) != NULL) {
-		ret = strstr(config_buf, units_str);
-		if (NULL != ret) {
-			if (47 < ret[strlen(ret) - 3] && 58 > ret[strlen(ret) - 3]) {
-				units = (10 * (ret[strlen(ret) - 3] - '0')) + (ret[strlen(ret) - 2] - '0');
-
-			}
-			else {
-				units = ret[strlen(ret) - 2] - '0';
-			}
-		}
-		else {
-			ret = strstr(config_buf, delay_str);
-			if (NULL != ret) {
-				if (47 < ret[strlen(ret) - 3] && 58 > ret[strlen(ret) - 3]) {
-					delay = (10 * (ret[strlen(ret) - 3] - '0')) + (ret[strlen(ret) - 2] - '0');
-
-				}
-				else {
-					delay = ret[strlen(ret) - 2] - '0';
-				}
-			}
-		}
-	}
-
-	fclose(config);
-	if (-1 == units || -1 == delay) {
-		printf("error at init_unit of type: %s", units_names[type]);
-		return 0;
-	}
-
-	for (i = 0; i < units; i++) {
-		init_unit(u_ptr);
-		u.type = type;
-		u.delay = delay;
-		u.index = i;
-		u.inst_ptr = -1;
-		insert_unit_array(fu, u);
-	}
-
-	return 1;
-}
-
-/*
-	Reads from the configuration text file the desired unit to trace.
-	return a 2 int array such that the first item is the type of the unit and the second item is the index of that unit.
-*/
-int getTraceUnit(char* cfg_path) {
-	int unit_index = -1, i, unit_name_len;
-	int trace[2];
-	char trace_str[20];
-	char *ret;
-	FILE* config;
-	char config_buf[BUF_SIZE];
-
-	strcpy(trace_str, "trace_unit = ");
-
-	config = fopen(cfg_path, "r");
-	if (config == NULL) {
-		printf("couldn't open the config file");
-		return 0;
-	}
-
-	while (fgets(config_buf, BUF_SIZE, config) != NULL) {
-		ret = strstr(config_buf, trace_str);
-		if (NULL != ret) {
-
-			switch (ret[strlen(trace_str)]) {
-			case 'A':
-				unit_name_len = 3;
-				trace[0] = OP_ADD;
-				break;
-			case 'L':
-				unit_name_len = 2;
-				trace[0] = OP_LD;
-				break;
-			case 'M':
-				unit_name_len = 3;
-				trace[0] = OP_MULT;
-				break;
-			case 'D':
-				unit_name_len = 3;
-				trace[0] = OP_DIV;
-				break;
-			case 'S':
-				if (ret[strlen(trace_str)] == 'U') {
-					// SU -> SUB
-					unit_name_len = 3;
-					trace[0] = OP_SUB;
-				}
-				else {
-					unit_name_len = 2;
-					trace[0] = OP_ST;
-				}
-				break;
-			}
-
-			if (47 > ret[strlen(trace_str) + unit_name_len + 1] || 58 < ret[strlen(trace_str) + unit_name_len + 1]) {
-				unit_index = ret[strlen(trace_str) + unit_name_len] - '0';
-			}
-			else {
-				unit_index = (10 * (ret[strlen(trace_str) + unit_name_len] - '0')) + (ret[strlen(trace_str) + unit_name_len + 1] - '0');
-			}
-			trace[1] = unit_index;
-		}
-	}
-
-	fclose(config);
-
-	return trace;
-}
-
-void setUnitInstIdx(Unit_arr * fu, int dst, int src) {
-	int i = 0, units_size = (int)fu->size;
-	for (i = 0; i < units_size; i++) {
-		if (fu->array[i].inst_idx == src) {
-			fu->array[i].inst_idx = dst;
-		}
-	}
-}
-
-/*
-	Moves an instruction inside the Queue from src to dst
-*/
-void moveInstInQueue(Inst *q, int dst, int src, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	q[dst] = q[src];
-	q[src] = init_inst();
-
-	setUnitInstIdx(add, dst, src);
-	setUnitInstIdx(sub, dst, src);
-	setUnitInstIdx(mult, dst, src);
-	setUnitInstIdx(div, dst, src);
-	setUnitInstIdx(load, dst, src);
-	setUnitInstIdx(store, dst, src);
-}
-
-/*
-	If there are spaces in the queue it narrows them by moving elemnts from right to left.
-	Return the most left free spot if free, if no place is free return -1
-*/
-int organizeQueue(Inst *q, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	int is_free = -1;
-	int i = 0, j = 0;
-	for (i = 0; i < 16; i++) {
-		if (q[i].inst != 0 && q[i].write > 0) {
-			q[i] = init_inst();
-		}
-	}
-	for (i = 0; i < 16; i++) {
-		if (q[i].inst == 0) { //If this spot in queue is empty			
-			for (j = i + 1; j < 16; j++) {
-				if (q[j].inst != 0) {
-					moveInstInQueue(q, i, j, add, sub, mult, div, load, store);
-					break;
-				}
-			}
-		}
-		if (j == 16) {
-			is_free = i;
-			break;
-		}
-	}
-	return is_free;
-}
-
-/*
-	Gets and instruction value as int and the queue, "fetching" the instucrion to the queue if there is an free space.
-*/
-int fetch(Inst *q, int inst, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	Inst i;
-	int free_spot;
-	free_spot = organizeQueue(q, add, sub, mult, div, load, store);
-	if (-1 != free_spot) {
-		i = createInst(inst);
-		q[free_spot] = i;
-		return 1;
-	}
-
-	
-	return 0;
-}
-
-/*
-	Gets an instruction and proper Unit array and issues that instruction to the array.
-	Setting all needed values for both the unit and the instruction elements
-*/
-int issueFuncUnitArr(int *busy_type, int *busy_idx, Unit_arr * fu, Inst *inst, int inst_idx) {
-	int i = 0, units_size = (int)fu->size;
-	for (i = 0; i < units_size; i++) {
-		if (fu->array[i].busy == 0) {
-			inst->unit_index = i;
-			fu->array[i].busy = 1;
-			fu->array[i].f_i = inst->dst;
-			fu->array[i].f_j = inst->src0;
-			fu->array[i].f_k = inst->src1;
-			if (-1 == busy_type[inst->src0]) {
-				fu->array[i].r_j = 1; // src0 is not busy
-			}
-			else {
-				fu->array[i].r_j = 0;
-			}
-			if (-1 == busy_type[inst->src1]) {
-				fu->array[i].r_k = 1; // src1 is not busy
-			}
-			else {
-				fu->array[i].r_k = 0;
-			}
-			fu->array[i].q_j_type = busy_type[inst->src0];
-			fu->array[i].q_j_idx = busy_idx[inst->src0];
-
-			fu->array[i].q_k_type = busy_type[inst->src1];
-			fu->array[i].q_k_idx = busy_idx[inst->src1];
-
-			if (busy_type[inst->dst] != -1) { // Some units is writing to the same dest
-				fu->array[i].waw_flag = 1;
-			}
-			else {
-				busy_type[inst->dst] = fu->array[i].type;
-				busy_idx[inst->dst] = fu->array[i].index;
-			}
-			
-			fu->array[i].inst_ptr = inst;
-			fu->array[i].inst_idx = inst_idx;
-			return 1;
-		}
-	}
-	return 0;
-}
-
-/*
-	Going over the instructions queue and issues the upcoming instruction.
-*/
-void issue(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	int i = 0, is_issued = 0, index_to_issue = -1, is_q_empty = 1;
-	//for (i = 15; i >= 0; i--) {
-	//	if (i == 0 && (q[i].issue == -1) && (q[15].issue != -1)) {
-	//		index_to_issue = 0;
-	//		break;
-	//	}
-	//	if ((q[i].issue == -1) && (q[i - 1].issue != -1)) { // i is at a non-issued instruction and its previos has been issued
-	//		index_to_issue = i;
-	//		break;
-	//	}
-	//}
-	for (i = 0; i < 16; i++) {
-		if (q[i].issue == -1) { //If this spot in queue is empty
-
-			switch (q[i].opcode) {
-			case OP_ADD:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, add, &q[i], i);
-				break;
-			case OP_SUB:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, sub, &q[i], i);
-				break;
-			case OP_MULT:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, mult, &q[i], i);
-				break;
-			case OP_DIV:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, div, &q[i], i);
-				break;
-			case OP_LD:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, load, &q[i], i);
-				break;
-			case OP_ST:
-				is_issued = issueFuncUnitArr(busy_type, busy_idx, store, &q[i], i);
-				break;
-			}
-			if (is_issued) {
-				q[i].issue = cc;
-			}
-			break;
-		}
-	}
-}
-
-/*
-	The following functions handle each step of the scoreboard algorithm, each one executes every cycle.
-	Each function goes over all of the functional units by going over each type array of units.
-	For every units it check if the handle can be exectued.
-*/
-void readOper(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	int i = 0;
-	// Going over Add units
-	for (i = 0; i < add->used; i++) {
-		if ((add->array[i].busy == 1) &&  (add->array[i].inst_idx != -1) && add->array[i].r_j == 1 && add->array[i].r_k == 1 && cc > q[add->array[i].inst_idx].issue && (-1 != q[add->array[i].inst_idx].issue)) {
-			if (add->array[i].inst_idx != -1 && q[add->array[i].inst_idx].read == -1) {
-				if (add->array[i].waw_flag) {
-					if (busy_idx[add->array[i].f_i] == -1) { // This unit dest register is free (WAW)
-						busy_type[add->array[i].f_i] = add->array[i].type;
-						busy_idx[add->array[i].f_i] = add->array[i].index;
-					}
-				}
-
-				if (busy_idx[add->array[i].f_i] == -1 || (busy_idx[add->array[i].f_i] == add->array[i].index && busy_type[add->array[i].f_i] == OP_ADD)) { // This unit dest register is free (WAW)
-					q[add->array[i].inst_idx].read = cc;
-					add->array[i].remain = add->array[i].delay - 1;
-					add->array[i].q_j_idx = -1;
-					add->array[i].q_k_idx = -1;
-				}
-			}
-		}
-	}
-	// Going over Sub units
-	for (i = 0; i < sub->used; i++) {
-		if (sub->array[i].inst_idx != -1 && sub->array[i].r_j == 1 && sub->array[i].r_k == 1 && cc >  q[sub->array[i].inst_idx].issue && -1 !=  q[sub->array[i].inst_idx].issue) {
-			if (sub->array[i].inst_idx != -1 &&  q[sub->array[i].inst_idx].read == -1) {
-				if (sub->array[i].waw_flag) {
-					if (busy_idx[sub->array[i].f_i] == -1) { // This unit dest register is free (WAW)
-						busy_type[sub->array[i].f_i] = sub->array[i].type;
-						busy_idx[sub->array[i].f_i] = sub->array[i].index;
-					}
-				}
-
-				if (busy_idx[sub->array[i].f_i] == -1 || (busy_idx[sub->array[i].f_i] == sub->array[i].index && busy_type[sub->array[i].f_i] == OP_SUB)) { // This unit dest register is free (WAW)
-					 q[sub->array[i].inst_idx].read = cc;
-					sub->array[i].remain = sub->array[i].delay - 1;
-				}
-			}
-		}
-	}
-	// Going over Mult units
-	for (i = 0; i < mult->used; i++) {
-		if (mult->array[i].inst_idx != -1 && mult->array[i].r_j == 1 && mult->array[i].r_k == 1 && cc > q[mult->array[i].inst_idx].issue && -1 != q[mult->array[i].inst_idx].issue) {
-			if (mult->array[i].inst_idx != -1 && q[mult->array[i].inst_idx].read == -1) {
-				if (mult->array[i].waw_flag) {
-					if (busy_idx[mult->array[i].f_i] == -1) { // This unit dest register is free (WAW)
-						busy_type[mult->array[i].f_i] = mult->array[i].type;
-						busy_idx[mult->array[i].f_i] = mult->array[i].index;
-					}
-				}
-				if (busy_idx[mult->array[i].f_i] == -1 || (busy_idx[mult->array[i].f_i] == mult->array[i].index && busy_type[mult->array[i].f_i] == OP_MULT)) { // This unit dest register is free (WAW)
-					q[mult->array[i].inst_idx].read = cc;
-					mult->array[i].remain = mult->array[i].delay - 1;
-				}
-			}
-		}
-	}
-	// Going over Div units
-	for (i = 0; i < div->used; i++) {
-		if (div->array[i].inst_idx != -1 && div->array[i].r_j == 1 && div->array[i].r_k == 1 && cc > q[div->array[i].inst_idx].issue && -1 != q[div->array[i].inst_idx].issue) {
-			if (q[div->array[i].inst_idx].read == -1) {
-				if (div->array[i].waw_flag) {
-					if (busy_idx[div->array[i].f_i] == -1) { // This unit dest register is free (WAW)
-						busy_type[div->array[i].f_i] = div->array[i].type;
-						busy_idx[div->array[i].f_i] = div->array[i].index;
-					}
-				}
-				if (busy_idx[div->array[i].f_i] == -1 || (busy_idx[div->array[i].f_i] == div->array[i].index && busy_type[div->array[i].f_i] == OP_DIV)) { // This unit dest register is free (WAW)
-					q[div->array[i].inst_idx].read = cc;
-					div->array[i].remain = div->array[i].delay - 1;
-				}
-			}
-		}
-	}
-	// Going over Load units
-	for (i = 0; i < load->used; i++) {
-		if (load->array[i].inst_idx != -1 && cc > q[load->array[i].inst_idx].issue && -1 != q[load->array[i].inst_idx].issue) {
-			if (q[load->array[i].inst_idx].read == -1) {
-				if (load->array[i].waw_flag) {
-					if (busy_idx[load->array[i].f_i] == -1) { // This unit dest register is free (WAW)
-						busy_type[load->array[i].f_i] = load->array[i].type;
-						busy_idx[load->array[i].f_i] = load->array[i].index;
-					}
-				}
-				if (busy_idx[load->array[i].f_i] == -1 || (busy_idx[load->array[i].f_i] == load->array[i].index && busy_type[load->array[i].f_i] == OP_LD)) { // This unit dest register is free (WAW)
-					q[load->array[i].inst_idx].read = cc;
-					load->array[i].remain = load->array[i].delay - 1;
-
-				}
-			}
-		}
-	}
-	// Going over Store units
-	for (i = 0; i < store->used; i++) {
-		if (store->array[i].inst_idx != -1 && store->array[i].r_k == 1 && cc > q[store->array[i].inst_idx].issue && -1 != q[store->array[i].inst_idx].issue) {
-			if (q[store->array[i].inst_idx].read == -1) {
-				q[store->array[i].inst_idx].read = cc;
-				store->array[i].remain = store->array[i].delay - 1;
-			}
-		}
-	}
-}
-
-void execComp(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store, int *MEM) {
-	int i = 0, load_temp, j = 0;
-	// Goinf over Add units
-	for (i = 0; i < add->used; i++) {
-		if (add->array[i].r_j == 1 && add->array[i].r_k == 1) {
-			if (add->array[i].remain >= 0 && q[add->array[i].inst_idx].read <= cc && q[add->array[i].inst_idx].read > 0) { // last cycle this fu completed read operation.
-				busy_type[add->array[i].f_i] = OP_ADD;
-				busy_idx[add->array[i].f_i] = add->array[i].index;
-
-				if (add->array[i].result == -1) {
-					add->array[i].result = F[add->array[i].f_j] + F[add->array[i].f_k];
-				}
-				add->array[i].remain--;
-				if (add->array[i].remain <= 0) {
-					q[add->array[i].inst_idx].exec = cc;
-				}
-			}
-		}
-	}
-	// Going over Sub units
-	for (i = 0; i < sub->used; i++) {
-		if (sub->array[i].r_j == 1 && sub->array[i].r_k == 1) {
-			if (sub->array[i].remain > 0 && q[sub->array[i].inst_idx].read < cc) { // last cycle this fu completed read operation.
-				if (sub->array[i].result == -1) {
-					sub->array[i].result = F[sub->array[i].f_j] - F[sub->array[i].f_k];
-				}
-				sub->array[i].remain--;
-				if (sub->array[i].remain == 0) {
-					 q[sub->array[i].inst_idx].exec = cc;
-				}
-			}
-		}
-	}
-	// Going over MUlt units
-	for (i = 0; i < mult->used; i++) {
-		if (mult->array[i].r_j == 1 && mult->array[i].r_k == 1) {
-			if (mult->array[i].remain > 0 && q[mult->array[i].inst_idx].read < cc) { // last cycle this fu completed read operation.
-				if (mult->array[i].result == -1) {
-					mult->array[i].result = F[mult->array[i].f_j] * F[mult->array[i].f_k];
-				}
-				mult->array[i].remain--;
-				if (mult->array[i].remain == 0) {
-					q[mult->array[i].inst_idx].exec = cc;
-				}
-			}
-		}
-	}
-	// Going over Div units
-	for (i = 0; i < div->used; i++) {
-		if (div->array[i].r_j == 1 && div->array[i].r_k == 1) {
-			if (div->array[i].remain > 0 && q[div->array[i].inst_idx].read < cc) { // last cycle this fu completed read operation.
-				if (div->array[i].result == -1) {
-					div->array[i].result = F[div->array[i].f_j] / F[div->array[i].f_k];
-				}
-				div->array[i].remain--;
-				if (div->array[i].remain == 0) {
-					q[div->array[i].inst_idx].exec = cc;
-				}
-			}
-		}
-	}
-	// Going over Load units
-	for (i = 0; i < load->used; i++) {
-		if (load->array[i].remain > 0 && q[load->array[i].inst_idx].read < cc) { // last cycle this fu completed read operation.
-			busy_type[load->array[i].f_i] = OP_LD;
-			busy_idx[load->array[i].f_i] = load->array[i].index;
-			if (load->array[i].result == -1) {
-				load_temp = MEM[q[load->array[i].inst_idx].imm];
-				load->array[i].result = single_pre_to_float(load_temp);
-			}
-			load->array[i].remain--;
-
-			if (load->array[i].remain == 0) {
-				q[load->array[i].inst_idx].exec = cc;
-			}
-		}
-	}
-	// Going over Store units
-	for (i = 0; i < store->used; i++) {
-		if (store->array[i].r_k == 1) {
-			if (store->array[i].remain > 0 && q[store->array[i].inst_idx].read < cc) { // last cycle this fu completed read operation.
-				busy_type[store->array[i].f_i] = OP_ST;
-				busy_idx[store->array[i].f_i] = store->array[i].index;
-				if (store->array[i].result == -1) {
-					store->array[i].result = F[store->array[i].f_k];
-				}
-				store->array[i].remain--;
-
-				// To check if load inst colide with this store inst, if so, delay the store execution
-				for (j = 0; j < load->used; j++) {
-					// Check if addresses values of store and load collide
-					if (load->array[j].inst_idx != -1) {
-						if (q[load->array[j].inst_idx].imm == q[store->array[i].inst_idx].imm) {
-							// Check that colided load inst is issued before store
-							if (q[load->array[j].inst_idx].issue < q[store->array[i].inst_idx].issue) {
-								// Check if load instruction finished it execution
-								if (q[load->array[j].inst_idx].exec <= cc) {
-									// If load inst has not finished its execution delayed store 1 more cycle
-									if (store->array[i].remain == 0) {
-										store->array[i].remain++;
-									}
-								}
-							}
-						}
-					}
-				}
-				if (store->array[i].remain == 0) {
-					MEM[q[store->array[i].inst_idx].imm] = floatToSinglePre(store->array[i].result);
-					q[store->array[i].inst_idx].exec = cc;
-				}
-			}
-		}
-	}
-}
-
-void writeBack(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	int i = 0;
-	// Going over Add units
-	for (i = 0; i < add->used; i++) {
-
-		if (add->array[i].inst_idx != -1 && q[add->array[i].inst_idx].exec > 0 && q[add->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation
-			if (add->array[i].remain <= 0) {
-				F[add->array[i].f_i] = add->array[i].result;
-				q[add->array[i].inst_idx].write = cc;
-				if (busy_type[q[add->array[i].inst_idx].dst] == OP_ADD && busy_idx[q[add->array[i].inst_idx].dst] == i) {
-					busy_type[q[add->array[i].inst_idx].dst] = -1;
-					busy_idx[q[add->array[i].inst_idx].dst] = -1;
-				}
-
-				reset_unit(&add->array[i]);
-			}
-		}
-	}
-
-	// Going over Sub units
-	for (i = 0; i < sub->used; i++) {
-		if (sub->array[i].remain == 0) {
-			if ( q[sub->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation.
-				F[sub->array[i].f_i] = sub->array[i].result;
-				 q[sub->array[i].inst_idx].write = cc;
-				 if (busy_type[q[sub->array[i].inst_idx].dst] == OP_SUB && busy_idx[q[sub->array[i].inst_idx].dst] == i) {
-					 busy_type[q[sub->array[i].inst_idx].dst] = -1;
-					 busy_idx[q[sub->array[i].inst_idx].dst] = -1;
-				 }
-				reset_unit(&sub->array[i]);
-			}
-		}
-	}
-
-	// Going over Mult units
-	for (i = 0; i < mult->used; i++) {
-		if (mult->array[i].remain == 0) {
-			if (q[mult->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation.
-				F[mult->array[i].f_i] = mult->array[i].result;
-				q[mult->array[i].inst_idx].write = cc;
-				if (busy_type[q[mult->array[i].inst_idx].dst] == OP_MULT && busy_idx[q[mult->array[i].inst_idx].dst] == i) {
-					busy_type[q[mult->array[i].inst_idx].dst] = -1;
-					busy_idx[q[mult->array[i].inst_idx].dst] = -1;
-				}
-				reset_unit(&mult->array[i]);
-			}
-		}
-	}
-
-	// Going over Div units
-	for (i = 0; i < div->used; i++) {
-		if (div->array[i].remain == 0) {
-			if (q[div->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation.
-				F[div->array[i].f_i] = div->array[i].result;
-				q[div->array[i].inst_idx].write = cc;
-				if (busy_type[q[div->array[i].inst_idx].dst] == OP_DIV && busy_idx[q[div->array[i].inst_idx].dst] == i) {
-					busy_type[q[div->array[i].inst_idx].dst] = -1;
-					busy_idx[q[div->array[i].inst_idx].dst] = -1;
-				}
-				reset_unit(&div->array[i]);
-
-			}
-		}
-	}
-
-	// Going over Load units
-	for (i = 0; i < load->used; i++) {
-		if (load->array[i].remain == 0) {
-			if (q[load->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation.
-				F[load->array[i].f_i] = load->array[i].result;
-				q[load->array[i].inst_idx].write = cc;
-				if (busy_type[q[load->array[i].inst_idx].dst] == OP_LD && busy_idx[q[load->array[i].inst_idx].dst] == i) {
-					busy_type[load->array[i].f_i] = -1;
-					busy_idx[load->array[i].f_i] = -1;
-				}
-				reset_unit(&load->array[i]);
-			}
-		}
-	}
-	// Going over Store units
-	for (i = 0; i < store->used; i++) {
-		if (store->array[i].remain == 0) {
-			if (q[store->array[i].inst_idx].exec < cc) { // last cycle this fu completed read operation.
-				q[store->array[i].inst_idx].write = cc;
-				if (busy_type[q[store->array[i].inst_idx].dst] == OP_ST && busy_idx[q[store->array[i].inst_idx].dst] == i) {
-					busy_type[q[store->array[i].inst_idx].dst] = -1;
-					busy_idx[q[store->array[i].inst_idx].dst] = -1;
-				}
-				reset_unit(&store->array[i]);
-			}
-		}
-	}
-}
-
-/*
-	Extra function to clear the Status array and notify the units for next cycle which of the registers is free to read from.
-*/
-
-void clearBusyReg(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_arr * add, Unit_arr * sub, Unit_arr * mult, Unit_arr * div, Unit_arr * load, Unit_arr * store) {
-	int i = 0;
-	int src0, src1;
-	// Going over Add units
-	for (i = 0; i < add->used; i++) {
-		if (busy_idx[add->array[i].f_j] == -1) {
-			add->array[i].r_j = 1;
-			add->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[add->array[i].f_k] == -1) {
-			add->array[i].r_k = 1;
-			add->array[i].q_k_idx = -1;
-		}
-	}
-
-	// Going over Sub units
-	for (i = 0; i < sub->used; i++) {
-		if (busy_idx[sub->array[i].f_j] == -1) {
-			sub->array[i].r_j = 1;
-			sub->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[sub->array[i].f_k] == -1) {
-			sub->array[i].r_k = 1;
-			sub->array[i].q_k_idx = -1;
-		}
-	}
-
-	// Going over Mult units
-	for (i = 0; i < mult->used; i++) {
-		if (busy_idx[mult->array[i].f_j] == -1) {
-			mult->array[i].r_j = 1;
-			mult->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[mult->array[i].f_k] == -1) {
-			mult->array[i].r_k = 1;
-			mult->array[i].q_k_idx = -1;
-		}
-	}
-
-	// Going over div units
-	for (i = 0; i < div->used; i++) {
-		if (busy_idx[div->array[i].f_j] == -1) {
-			div->array[i].r_j = 1;
-			div->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[div->array[i].f_k] == -1) {
-			div->array[i].r_k = 1;
-			div->array[i].q_k_idx = -1;
-		}
-	}
-
-	// Going over load units
-	for (i = 0; i < load->used; i++) {
-		if (busy_idx[load->array[i].f_j] == -1) {
-			load->array[i].r_j = 1;
-			load->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[load->array[i].f_k] == -1) {
-			load->array[i].r_k = 1;
-			load->array[i].q_k_idx = -1;
-		}
-	}
-
-	// Going over store units
-	for (i = 0; i < store->used; i++) {
-		if (busy_idx[store->array[i].f_j] == -1) {
-			store->array[i].r_j = 1;
-			store->array[i].q_j_idx = -1;
-		}
-		if (busy_idx[store->array[i].f_k] == -1) {
-			store->array[i].r_k = 1;
-			store->array[i].q_k_idx = -1;
-		}
-	}
-
-}
-
-
-int main(int argc, char** argv) {
-	// Declarations
-	Unit_arr fu_sub, fu_mult, fu_add, fu_divide, fu_load, fu_store;
-	float F[16];
-	// The status array is designed by 2 array of int, for each register index the arrays are indicates which unit has handle to it
-	// 1 array is to indicate the unit type, second array is for the unit index
-	int busy_type[16];
-	int busy_idx[16];
-	Inst q[16];
-	// For memory in
-	int MEM[MEM_LENGTH_SIM] = { 0 };
-	int num_line = 0, inst_num = 0, i;
-	int cc = 1;
-	// For the trace unit, same as status array, both values indicates the type and index of the unit.
-	int t_type, t_index;
-	int *trace_unit_name;
-	char *line;
-	// flag if halt wa reached
-	int halt_reached = 0;
-
-	// For printing purposes, for the trace unit its r_j and r_k values.
-	int to_print_r_j = 0, to_print_r_k = 0;
-	// Flag to indicates if the simulation is running
-	int sim = 1;
-
-	// "remebers" which instruction is needed to be written next by the issue order.
-	int issue_to_print = 1;
-
-	// String variables for printing purposes.
-	char q_j[6];
-	char q_k[6];
-
-	// File pointers
-	FILE* memin;
-	FILE* memout;
-	FILE* trace_inst;
-	FILE* trace_unit;
-	FILE* regout;
-
-	//Allocations
-	line = calloc(1, sizeof(char)*MAX_LINE_LENGTH);
-	if (line == NULL) {
-		printf("Fail to calloc line\n");
-		return 0;
-	}
-
-	//Initialization
-	init_unit_array(&fu_add, 1);
-	init_units(argv[1], &fu_add, OP_ADD);
-
-	init_unit_array(&fu_sub, 1);
-	init_units(argv[1], &fu_sub, OP_SUB);
-
-	init_unit_array(&fu_mult, 1);
-	init_units(argv[1], &fu_mult, OP_MULT);
-
-	init_unit_array(&fu_divide, 1);
-	init_units(argv[1], &fu_divide, OP_DIV);
-
-	init_unit_array(&fu_load, 1);
-	init_units(argv[1], &fu_load, OP_LD);
-
-	init_unit_array(&fu_store, 1);
-	init_units(argv[1], &fu_store, OP_ST);
-
-
-	// Inits instructions queue
-	for (i = 0; i < 16; i++) {
-		q[i] = init_inst();
-	}
-
-	// Inits registers
-	for (i = 0; i < 16; i++) {
-		F[i] = 1.0 * i;
-		busy_idx[i] = -1;
-		busy_type[i] = -1;
-	}
-
-	//Scaning input memory to MEM
-	memin = fopen(argv[2], "r");
-	if (memin == NULL) {
-		printf("couldn't open the memin file");
-		return 0;
-	}
-	trace_inst = fopen(argv[5], "w");
-	if (trace_inst == NULL) {
-		printf("couldn't open the traceinst file");
-		return 0;
-	}
-	trace_unit = fopen(argv[6], "w");
-	if (trace_unit == NULL) {
-		printf("couldn't open the trace_unit file");
-		return 0;
-	}
-
-
-	while (fgets(line, MAX_LINE_LENGTH, memin) != NULL) {
-		sscanf(line, "%x", &MEM[num_line]);
-		num_line++;
-	}
-
-	i = 0;
-	// Doing the first fetch before starts to run.
-	inst_num += fetch(q, MEM[inst_num], &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-	issue(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-	cc++;
-	trace_unit_name = getTraceUnit(argv[1]);
-	t_type = trace_unit_name[0];
-	t_index = trace_unit_name[1];
-
-	while (sim) {
-
-		strcpy(q_j, "-");
-		strcpy(q_k, "-");
-		switch (t_type) {
-		case OP_ADD:
-			if (fu_add.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_ADD], fu_add.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_add.array[t_index].f_i, fu_add.array[t_index].f_j, fu_add.array[t_index].f_k);
-				to_print_r_j = fu_add.array[t_index].r_j;
-				to_print_r_k = fu_add.array[t_index].r_k;
-				if (fu_add.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_add.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_add.array[t_index].q_j_type], fu_add.array[t_index].q_j_idx);
-				}
-				if (fu_add.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_add.array[t_index].q_k_type], fu_add.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		case OP_SUB:
-			if (fu_sub.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_SUB], fu_sub.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_sub.array[t_index].f_i, fu_sub.array[t_index].f_j, fu_sub.array[t_index].f_k);
-				to_print_r_j = fu_sub.array[t_index].r_j;
-				to_print_r_k = fu_sub.array[t_index].r_k;
-				if (fu_sub.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_sub.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_sub.array[t_index].q_j_type], fu_sub.array[t_index].q_j_idx);
-				}
-				if (fu_sub.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_sub.array[t_index].q_k_type], fu_sub.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		case OP_MULT:
-			if (fu_mult.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_MULT], fu_mult.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_mult.array[t_index].f_i, fu_mult.array[t_index].f_j, fu_mult.array[t_index].f_k);
-				to_print_r_j = fu_mult.array[t_index].r_j;
-				to_print_r_k = fu_mult.array[t_index].r_k;
-				if (fu_mult.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_mult.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_mult.array[t_index].q_j_type], fu_mult.array[t_index].q_j_idx);
-				}
-				if (fu_mult.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_mult.array[t_index].q_k_type], fu_mult.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		case OP_DIV:
-			if (fu_divide.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_DIV], fu_divide.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_divide.array[t_index].f_i, fu_divide.array[t_index].f_j, fu_divide.array[t_index].f_k);
-				to_print_r_j = fu_divide.array[t_index].r_j;
-				to_print_r_k = fu_divide.array[t_index].r_k;
-				if (fu_divide.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_divide.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_divide.array[t_index].q_j_type], fu_divide.array[t_index].q_j_idx);
-				}
-				if (fu_divide.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_divide.array[t_index].q_k_type], fu_divide.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		case OP_LD:
-			if (fu_load.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_LD], fu_load.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_load.array[t_index].f_i, fu_load.array[t_index].f_j, fu_load.array[t_index].f_k);
-				to_print_r_j = fu_load.array[t_index].r_j;
-				to_print_r_k = fu_load.array[t_index].r_k;
-				if (fu_load.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_load.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_load.array[t_index].q_j_type], fu_load.array[t_index].q_j_idx);
-				}
-				if (fu_load.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_load.array[t_index].q_k_type], fu_load.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		case OP_ST:
-			if (fu_store.array[t_index].busy == 1) {
-				fprintf(trace_unit, "%d %s%d", cc, units_names[OP_ST], fu_store.array[t_index].index);
-				fprintf(trace_unit, " F%d F%d F%d", fu_store.array[t_index].f_i, fu_store.array[t_index].f_j, fu_store.array[t_index].f_k);
-				to_print_r_j = fu_store.array[t_index].r_j;
-				to_print_r_k = fu_store.array[t_index].r_k;
-				if (fu_store.array[t_index].inst_ptr->exec > 0) {
-					to_print_r_j = 0;;
-					to_print_r_k = 0;;
-				}
-				if (fu_store.array[t_index].q_j_idx != -1) {
-					sprintf(q_j, "%s%d", units_names[fu_store.array[t_index].q_j_type], fu_store.array[t_index].q_j_idx);
-				}
-				if (fu_store.array[t_index].q_k_idx != -1) {
-					sprintf(q_k, "%s%d", units_names[fu_store.array[t_index].q_k_type], fu_store.array[t_index].q_k_idx);
-				}
-				fprintf(trace_unit, " %s %s %s %s\n", q_j, q_k, yes_no[to_print_r_j], yes_no[to_print_r_k]);
-			}
-			break;
-		}
-
-
-
-		if (MEM[inst_num] != HALT_INST) {
-			inst_num += fetch(q, MEM[inst_num], &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-		}
-		else {
-			halt_reached = 1;
-		}
-		issue(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-		readOper(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-		execComp(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store, MEM);
-		writeBack(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-		clearBusyReg(F, busy_type, busy_idx, q, cc, &fu_add, &fu_sub, &fu_mult, &fu_divide, &fu_load, &fu_store);
-
-		cc++;
-
-
-		if (halt_reached) {
-			sim = 0;
-			for (i = 0; i < 16; i++) {
-				if (q[i].issue >= issue_to_print) {
-					sim = 1;
-					break;
-				}
-			}
-
-		}
-		for (i = 0; i < 16; i++) {
-			if (q[i].issue == issue_to_print) {
-				if (q[i].write > 0) {
-					fprintf(trace_inst, "%.8X %d %s%d %d %d %d %d\n", q[i].inst, issue_to_print - 1, units_names[q[i].opcode], q[i].unit_index, q[i].issue, q[i].read, q[i].exec, q[i].write);
-					issue_to_print++;
-				}
-				break;
-			}
-			//If gets here none of the instruction is issued to printing
-			if (i == 15) {
-				issue_to_print++;
-			}
-		}
-	}
-	fclose(trace_inst);
-
-
-	regout = fopen(argv[4], "w");
-	if (regout == NULL) {
-		printf("couldn't open the regout file");
-		return 0;
-	}
-	for (i = 0; i < 16; i++) {
-		fprintf(regout, "%f\n", F[i]);
-	}
-
-	memout = fopen(argv[3], "w");
-	if (memout == NULL) {
-		printf("couldn't open the memout file");
-		return 0;
-	}
-	for (i = 0; i < MEM_LENGTH_SIM; i++) {
-		fprintf(memout, "%.8X\n", MEM[i]);
-	}
-
-	fclose(memout);
-
-	return 0;
-}
\ No newline at end of file
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <stddef.h>
+#include <errno.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "sim.h"
+
+#define BUF_SIZE            1024
+
+#define MEM_LENGTH_SIM 4096
+#define MEM_ADDR_BITS 12
+#define PAGE_BITS 10
+#define PAGE_WORDS (1 << PAGE_BITS)
+#define TABLE_BITS 11
+#define TABLE_PAGES (1 << TABLE_BITS)
+// Default and maximal depth of the instructions queue, see the queue_depth cfg key
+#define QUEUE_DEPTH 16
+#define QUEUE_DEPTH_MAX (1 << 20)
+// Default words per line of the data cache, see the cache_line cfg key
+#define CACHE_LINE 8
+#define REGS_NUM 16
+#define SWEEP_MAX_VALUES 64
+#define SWEEP_MAX_POINTS (1 << 24)
+
+#define MAX_LINE_LENGTH 500
+#define HALT_INST 0x06000000
+#define TRACE_BUF_SIZE (1 << 20)
+#define TRACE_ROW_LENGTH 80
+
+
+
+static char yes_no[2][4] = { "No", "Yes" };
+//static char yes_no[2][4] = {"Yes", "No"};
+static char units_names[6][4] = { "LD", "ST", "ADD", "SUB", "MUL", "DIV" };
+static char units_names_low[6][4] = { "ld", "st", "add", "sub", "mul", "div" };
+/*
+	Instruction structure
+	Any value is document by the comment above it
+*/
+typedef struct {
+	// Instruction
+	int inst;
+
+	// Clock cycle that issue of this instruction occured.
+	int issue;
+
+	// Clock cycle that read of this instruction occured.
+	int read;
+
+	// Clock cycle that execution of this instruction finished.
+	int exec;
+
+	// Clock cycle that write back of this instruction occured.
+	int write;
+
+	// Instruction opcode
+	int opcode;
+
+	// Instruction destination
+	int dst;
+
+	// Instruction source 0
+	int src0;
+
+	// Instruction source 1
+	int src1;
+
+	// Instruction immidiate
+	int imm;
+
+	// Memory address of LD/ST, the immidiate, plus the base register value with base addressing
+	unsigned int addr;
+
+	// Instruction handkng unit index
+	int unit_index;
+
+} Inst;
+
+/*
+	Instructions queue, a circular window of size instructions (the queue_depth of the cfg).
+	An instruction keeps its slot in q from fetch until it is retired, so units can hold its slot index and pointer.
+	The queue positions are running sequence numbers, the slot of position n is n % size.
+	Fetch, issue and retire only touch the tail, next_issue and head slots, so a cycle costs the same for any depth.
+	head - position of the oldest instruction that was not retired yet
+	next_issue - position of the oldest instruction that was not issued yet
+	tail - position the next instruction is fetched to
+*/
+typedef struct {
+	Inst *q;
+	int size;
+	int head;
+	int next_issue;
+	int tail;
+} Inst_queue;
+
+/*
+	Memory dependence table, the mem_disambiguation cfg key.
+	The busy LD/ST units are listed by their memory address in a hash table, so a LD/ST only looks at the units of its own address
+	instead of at all of the LD/ST units. A unit whose address isn't known yet (base addressing, before its base register is read)
+	waits in the unknown list, and is moved to the list of its address once it's known (see depsResolve).
+	The listed stores that didn't write the memory yet are the store buffer, they forward their data to the later loads of their address.
+*/
+typedef struct {
+	// First unit of each address list, mask + 1 (a power of 2) lists, and of the unknown list. -1 for an empty list.
+	int *heads;
+	unsigned int mask;
+	int unknown;
+
+	// Next unit in the list of each unit of the table (-1 at the end of the list, -2 if the unit isn't listed), and its address
+	int *next;
+	unsigned int *addr;
+
+	// The engine, which tells when the address of a unit is known and when a unit accesses the memory
+	int tomasulo;
+} Mem_deps;
+
+// Flags of a cache line
+#define CACHE_VALID 1
+#define CACHE_DIRTY 2
+
+/*
+	Data cache between the LD/ST units and the memory, the cache_* cfg keys. It only times the accesses, the data is always in the memory.
+	A LD/ST looks up the line of its address when it reads its operands, and executes for the hit or the miss delay instead of its unit delay.
+	The ways lines of a set are in a row of the arrays, a line goes to the set of its line address modulo sets.
+	A store that misses fills its line (write allocate) and marks it dirty, a dirty line that is replaced is counted as a write back.
+*/
+typedef struct {
+	int sets;
+	int ways;
+	// Words per line
+	int line;
+	int policy;
+	int hit_delay;
+	// 0 for the delay of the unit
+	int miss_delay;
+
+	// Line address, flags and stamp of each line, sets * ways entries.
+	// The stamp is the access count at the last access of the line for LRU and at its fill for FIFO, the oldest is replaced.
+	unsigned int *tags;
+	unsigned char *flags;
+	unsigned long long *stamps;
+	unsigned long long accesses;
+	// State of the random replacement, a linear congruential generator so a run repeats
+	unsigned int seed;
+
+	// Hits and misses of the loads [0] and of the stores [1], and the dirty lines written back
+	long long hits[2];
+	long long misses[2];
+	long long write_backs;
+} Data_cache;
+
+/*
+	Function units table.
+	All of the function units of all types are kept in a single table in a structure of arrays layout,
+	each array is indexed by the unit id. Units of the same type are stored contiguously, in the order of fu_order.
+	Any value is documented by te comment above
+*/
+typedef struct {
+	// 0 for non-busy, 1 for busy
+	int *busy;
+
+	// register index for dest
+	int *f_i;
+
+	// register index for src0
+	int *f_j;
+
+	// register index for src1
+	int *f_k;
+
+	// which type function unit works on src0.
+	int *q_j_type;
+
+	// which index of function unit works on src0.
+	int *q_j_idx;
+
+	// which type function unit works on src0.
+	int *q_k_type;
+
+	// which index of function unit works on src0.
+	int *q_k_idx;
+
+	// 0 for no, 1 for yes.
+	int *r_j;
+
+	// 0 for no, 1 for yes.
+	int *r_k;
+
+	// type of the function unit
+	int *type;
+
+	// the number of clock cycle for this unit to finish
+	int *delay;
+
+	// the number of remaining clock cycle for this unit to finish.
+	int *remain;
+
+	// unit index number inside its type.
+	int *index;
+
+	// Physical unit number inside its type. A pipelined unit has several instructions in flight, one in each of its slots,
+	// every slot is a unit of the table with its own index (which the status arrays refer to) and the slots share the physical unit.
+	// The slots are stored slot after slot, index = unit + slot * units[type], so the first slots of all of the units come first.
+	int *unit;
+
+	// Clock cycle from which a pipelined unit may start its next instruction, kept at the first slot of the unit (see unitLead)
+	int *next_read;
+
+	// unit result value.
+	float *result;
+
+	// the instruction this unit in handle
+	Inst **inst_ptr;
+
+	// the instruction index that this unit in handle
+	int *inst_idx;
+
+	// Flag indicates this unit invloves in WAW
+	int *waw_flag;
+
+	// Source values captured by the Tomasulo engine, from the registers at issue or from the common data bus
+	float *v_j;
+	float *v_k;
+
+	// Number of clock cycles the unit was busy, from issue to write back, for the stats.
+	long long *busy_cycles;
+
+	// Per register bitmasks of the units waiting for that register to be free, 32 units per word.
+	// The mask word of unit u for register reg is waiters[(u / 32) * REGS_NUM + reg].
+	unsigned int *waiters;
+
+	// Bitmask of the units that hold an instruction (busy), 32 units per word. The clear bits are the free units.
+	// Each step goes over the set bits only, so idle units cost nothing.
+	unsigned int *active;
+
+	// Flag for LD/ST to address the memory by src0 as a base register plus the immidiate, so they also wait for src0.
+	int base_addressing;
+
+	// Memory dependence table of the LD/ST units, NULL if the cfg doesn't use it
+	Mem_deps *deps;
+
+	// Data cache of the LD/ST units, NULL if the cfg doesn't have one
+	Data_cache *cache;
+
+	// id of the first unit of each type and the number of units of each type, indexed by opcode.
+	int first[6];
+	int count[6];
+
+	// Number of physical units and of slots per unit of each type, and the initiation interval of the pipelined types (0 for the others)
+	int units[6];
+	int slots[6];
+	int ii[6];
+
+	// number of units in the table and number of allocated units in each array
+	size_t used;
+	size_t size;
+} Unit_table;
+
+// The order the unit types are stored in the table, which is also the order each step goes over them.
+static int fu_order[6] = { OP_ADD, OP_SUB, OP_MULT, OP_DIV, OP_LD, OP_ST };
+
+/*
+	Per type behavior of the function units, indexed by opcode (LD, ST, ADD, SUB, MUL, DIV).
+	fu_needs_j/fu_needs_k - the unit waits for src0/src1 to be ready before reading its operands.
+	fu_writes_reg - the unit writes a register, so it checks its dest register for WAW before reading.
+	fu_claims_dst - the unit marks its dest register in the status arrays on every execution cycle.
+	fu_eager - the unit starts counting down in its read cycle and down to -1 (ADD).
+*/
+static int fu_needs_j[6] = { 0, 0, 1, 1, 1, 1 };
+static int fu_needs_k[6] = { 0, 1, 1, 1, 1, 1 };
+static int fu_writes_reg[6] = { 1, 0, 1, 1, 1, 1 };
+static int fu_claims_dst[6] = { 1, 1, 1, 0, 0, 0 };
+static int fu_eager[6] = { 0, 0, 1, 0, 0, 0 };
+
+// The unit waits for src0, by its type or by the base addressing of LD/ST.
+#define needsJ(fu, type) (fu_needs_j[type] || ((fu)->base_addressing && ((type) == OP_LD || (type) == OP_ST)))
+
+// The first slot of the physical unit of a unit, which keeps the pipeline state of all of its slots.
+#define unitLead(fu, u) ((fu)->first[(fu)->type[u]] + (fu)->unit[u])
+
+/*
+	Simulated memory, an address space of up to 2^32 words in pages of PAGE_WORDS words.
+	The pages are found by a 2 level lookup, a table of TABLE_PAGES pages for each 2^(PAGE_BITS + TABLE_BITS) words.
+	Tables and pages are allocated on their first write, so untouched parts of the address space cost nothing and read as 0.
+	The words of an allocated page are right after it, or in the mapped memin image for the pages of a binary memin (see mapMemin).
+*/
+typedef struct {
+	int *words;
+
+	// Bitmask of the words written by stores, 32 words per mask word
+	unsigned int dirty[PAGE_WORDS / 32];
+} Mem_page;
+
+typedef struct {
+	// Address space size - 1, addresses wrap around it
+	unsigned int addr_mask;
+
+	Mem_page ***tables;
+	unsigned int tables_num;
+
+	// Binary memin image mapped copy-on-write as the initial memory, NULL if none
+	void *image;
+	size_t image_len;
+} Sim_mem;
+
+/*
+	Statistics of a run, written to the stats_file of the cfg (see writeStats).
+	A stall is counted once per clock cycle for each instruction it holds back:
+	structural - the next instruction to issue has no free unit of its type, or a pipelined unit holds an instruction from starting
+	WAW        - an issued instruction can't read its operands while another unit holds its dest register
+	RAW        - an issued instruction can't read its operands while a unit is still producing one of them
+	WAR        - a store is delayed while an earlier load of the same address didn't execute yet
+	The Tomasulo engine has no register WAW/WAR stalls, there a load waiting for an earlier store of its address is a RAW stall,
+	a store waiting for an earlier store a WAW stall and for an earlier load a WAR stall, and a result waiting for the common data bus
+	is a structural stall.
+*/
+#define STALL_STRUCT 0
+#define STALL_WAW    1
+#define STALL_RAW    2
+#define STALL_WAR    3
+#define STALL_CAUSES 4
+
+typedef struct {
+	long long cycles;
+	// Retired instructions
+	long long insts;
+	// Clock cycles an instruction was issued in, and ones with no fetched instruction left to issue
+	long long issue_cycles;
+	long long empty_cycles;
+	long long stalls[STALL_CAUSES];
+	// Clock cycles by the number of instructions in the queue at their end, queue size + 1 entries
+	long long *queue_hist;
+} Sim_stats;
+
+/*
+	Simulation context, all of the state of a single simulation run.
+*/
+typedef struct {
+	// Function units
+	Unit_table fu;
+
+	// Registers
+	float F[REGS_NUM];
+
+	// The status array is designed by 2 array of int, for each register index the arrays are indicates which unit has handle to it
+	// 1 array is to indicate the unit type, second array is for the unit index
+	int busy_type[REGS_NUM];
+	int busy_idx[REGS_NUM];
+
+	// Instructions queue
+	Inst_queue iq;
+
+	// Memory, initialized by memin
+	Sim_mem mem;
+
+	// Clock cycle
+	int cc;
+
+	// Number of fetched instructions, which is also the memory address of the next instruction to fetch
+	int inst_num;
+
+	// flag if halt wa reached
+	int halt_reached;
+
+	// Flag to convert loads and stores like the original float conversions did, see single_pre_to_float_legacy
+	int legacy_float;
+
+	// Maximal number of instructions fetched, issued and retired in a clock cycle
+	int fetch_width;
+	int issue_width;
+
+	// Flag to time the instructions by the Tomasulo engine instead of the scoreboard, see tomIssue
+	int tomasulo;
+
+	// Clock cycle to save a checkpoint at the start of, -1 for the cycle after halt was fetched, 0 for none. See saveCheckpoint.
+	int checkpoint_at;
+	char checkpoint_path[MAX_LINE_LENGTH];
+
+	// Sampled simulation: the address to stop fetching at as if it was halt (0 for none),
+	// and the clock cycle at which mark_retired instructions were retired, see simulateSampled.
+	int fetch_limit;
+	int mark_retired;
+	int mark_cc;
+
+	// Statistics of the clock cycles simulated by this context, the units busy cycles are in the units table.
+	Sim_stats stats;
+} Sim_ctx;
+
+/*
+	Trace files.
+	A trace file name ending with ".bin" is a binary trace: a 4 bytes magic ("SBTI" for traceinst, "SBTU" for traceunit)
+	followed by fixed size records in the native layout, which "sim -traceconv" converts back to the exact text trace.
+	The records are gathered in a large buffer, a background thread writes the full buffers while the simulation fills the other one.
+	Any other file name is a text trace, written directly.
+	The library keeps its instructions trace in memory instead (see simInstTimes).
+*/
+typedef Sim_inst_times Trace_inst_rec;
+
+typedef struct {
+	// First clock cycle of the row, and the number of cycles it repeats (an event driven skip is a single record)
+	int cc;
+	int cycles;
+	int index;
+	int q_j_idx;
+	int q_k_idx;
+	signed char type;
+	signed char f_i;
+	signed char f_j;
+	signed char f_k;
+	signed char q_j_type;
+	signed char q_k_type;
+	signed char r_j;
+	signed char r_k;
+} Trace_unit_rec;
+
+/*
+	Binary trace writer, double buffered.
+	The simulation fills bufs[fill_idx], a full buffer is handed to the writer thread as flush_len bytes of the other buffer.
+*/
+typedef struct {
+	FILE *file;
+	char *bufs[2];
+	int fill_idx;
+	size_t fill;
+	// Bytes of bufs[1 - fill_idx] the writer thread has to write, 0 when the writer is idle
+	size_t flush_len;
+	// Offset of the last unit record in bufs[fill_idx], to extend it by a repeating row. -1 if it isn't there.
+	long last_rec;
+	int closing;
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE cond;
+	HANDLE thread;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+#endif
+} Trace_writer;
+
+// The units traced to the traceunit file, and the window of cycles to trace
+typedef struct {
+	// Bitmask of the traced unit ids, 32 units per word
+	unsigned int *units;
+	int from;
+	int to;
+} Trace_set;
+
+typedef struct {
+	// Text trace file, NULL for a binary trace
+	FILE *text;
+	// Binary trace writer, NULL for a text trace
+	Trace_writer *bin;
+	// In memory instructions trace, NULL for a file
+	Trace_inst_rec *recs;
+	int recs_num;
+	int recs_size;
+} Trace_file;
+
+
+/*
+	The following functions get the insturction value as int and parse data from it
+	Each function parse diferent value by its name
+*/
+unsigned int parserOpcode(unsigned int inst) {
+	unsigned int opcode;
+	opcode = inst >> 24;
+	return opcode;
+}
+unsigned int parserDst(unsigned int inst) {
+	unsigned int dst;
+	inst <<= 8;
+	dst = inst >> 28;
+	return dst;
+}
+unsigned int parserSrc0(unsigned int inst) {
+	unsigned int src0;
+	inst <<= 12;
+	src0 = inst >> 28;
+	return src0;
+}
+unsigned int parserSrc1(unsigned int inst) {
+	unsigned int src1;
+	inst <<= 16;
+	src1 = inst >> 28;
+	return src1;
+}
+unsigned int parserImm(unsigned int inst) {
+	unsigned int imm;
+	imm = inst & 0xFFF;
+	return imm;
+}
+
+// Returns the index of the lowest set bit of a non zero mask
+int lowestBit(unsigned int mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return (int)idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+//Gets a unit of the table and resets its value. (f's, r's, q's, remain, instruction...)
+void reset_unit(Unit_table *fu, int u)
+{
+	fu->busy[u] = 0;
+	fu->f_i[u] = -1;
+	fu->f_j[u] = -1;
+	fu->f_k[u] = -1;
+	fu->q_j_idx[u] = -1;
+	fu->q_j_type[u] = -1;
+	fu->q_k_idx[u] = -1;
+	fu->q_k_type[u] = -1;
+	fu->remain[u] = -1;
+	fu->r_j[u] = 1;
+	fu->r_k[u] = 1;
+	fu->result[u] = -1;
+	fu->inst_idx[u] = -1;
+	fu->inst_ptr[u] = NULL;
+	fu->waw_flag[u] = 0;
+	fu->active[u / 32] &= ~(1u << (u % 32));
+
+}
+
+// Creates any empty instruction object
+Inst init_inst()
+{
+	Inst inst;
+	inst.inst = 0;
+	inst.exec = -1;
+	inst.issue = -1;
+	inst.read = -1;
+	inst.write = -1;
+	inst.opcode = -1;
+	inst.dst = -1;
+	inst.src0 = -1;
+	inst.src1 = -1;
+	inst.imm = -1;
+	inst.addr = 0;
+	inst.unit_index = -1;
+
+	return inst;
+}
+
+// Creates a full instruction element by the parsed data from the input value of the instruction.
+Inst createInst(int inst) {
+	Inst i = init_inst();
+	i.inst = inst;
+	i.opcode = parserOpcode(inst);
+
+	i.dst = parserDst(inst);
+	i.src0 = parserSrc0(inst);
+	i.src1 = parserSrc1(inst);
+	i.imm = parserImm(inst);
+	i.addr = i.imm;
+
+	return i;
+}
+
+// Initializing an empty Unit_table with room for initialSize units
+void init_unit_table(Unit_table *a, size_t initialSize)
+{
+	memset(a, 0, sizeof(Unit_table));
+	a->size = initialSize;
+	// Allocate initial space
+	a->busy = (int*)malloc(initialSize * sizeof(int));
+	a->f_i = (int*)malloc(initialSize * sizeof(int));
+	a->f_j = (int*)malloc(initialSize * sizeof(int));
+	a->f_k = (int*)malloc(initialSize * sizeof(int));
+	a->q_j_type = (int*)malloc(initialSize * sizeof(int));
+	a->q_j_idx = (int*)malloc(initialSize * sizeof(int));
+	a->q_k_type = (int*)malloc(initialSize * sizeof(int));
+	a->q_k_idx = (int*)malloc(initialSize * sizeof(int));
+	a->r_j = (int*)malloc(initialSize * sizeof(int));
+	a->r_k = (int*)malloc(initialSize * sizeof(int));
+	a->type = (int*)malloc(initialSize * sizeof(int));
+	a->delay = (int*)malloc(initialSize * sizeof(int));
+	a->remain = (int*)malloc(initialSize * sizeof(int));
+	a->index = (int*)malloc(initialSize * sizeof(int));
+	a->unit = (int*)malloc(initialSize * sizeof(int));
+	a->next_read = (int*)malloc(initialSize * sizeof(int));
+	a->result = (float*)malloc(initialSize * sizeof(float));
+	a->inst_ptr = (Inst**)malloc(initialSize * sizeof(Inst*));
+	a->inst_idx = (int*)malloc(initialSize * sizeof(int));
+	a->waw_flag = (int*)malloc(initialSize * sizeof(int));
+	a->v_j = (float*)malloc(initialSize * sizeof(float));
+	a->v_k = (float*)malloc(initialSize * sizeof(float));
+	a->busy_cycles = (long long*)malloc(initialSize * sizeof(long long));
+	a->waiters = NULL;
+	a->active = NULL;
+}
+
+// Free the memory of the Unit_table
+void free_unit_table(Unit_table *a)
+{
+	free(a->busy);
+	free(a->f_i);
+	free(a->f_j);
+	free(a->f_k);
+	free(a->q_j_type);
+	free(a->q_j_idx);
+	free(a->q_k_type);
+	free(a->q_k_idx);
+	free(a->r_j);
+	free(a->r_k);
+	free(a->type);
+	free(a->delay);
+	free(a->remain);
+	free(a->index);
+	free(a->unit);
+	free(a->next_read);
+	free(a->result);
+	free(a->inst_ptr);
+	free(a->inst_idx);
+	free(a->waw_flag);
+	free(a->v_j);
+	free(a->v_k);
+	free(a->busy_cycles);
+	free(a->waiters);
+	free(a->active);
+	if (a->deps != NULL) {
+		free(a->deps->heads);
+		free(a->deps->next);
+		free(a->deps->addr);
+		free(a->deps);
+	}
+	if (a->cache != NULL) {
+		free(a->cache->tags);
+		free(a->cache->flags);
+		free(a->cache->stamps);
+		free(a->cache);
+	}
+	memset(a, 0, sizeof(Unit_table));
+}
+
+
+// Inserts a new idle unit of the input type into the Unit_table, If the table is full its realloactes twice its memory.
+// Units of the same type must be inserted one after the other. unit is the physical unit of the inserted slot.
+void insert_unit_table(Unit_table *a, int type, int delay, int unit)
+{
+	int u;
+	if (a->used == a->size)
+	{
+		a->size *= 2;
+		a->busy = (int*)realloc(a->busy, a->size * sizeof(int));
+		a->f_i = (int*)realloc(a->f_i, a->size * sizeof(int));
+		a->f_j = (int*)realloc(a->f_j, a->size * sizeof(int));
+		a->f_k = (int*)realloc(a->f_k, a->size * sizeof(int));
+		a->q_j_type = (int*)realloc(a->q_j_type, a->size * sizeof(int));
+		a->q_j_idx = (int*)realloc(a->q_j_idx, a->size * sizeof(int));
+		a->q_k_type = (int*)realloc(a->q_k_type, a->size * sizeof(int));
+		a->q_k_idx = (int*)realloc(a->q_k_idx, a->size * sizeof(int));
+		a->r_j = (int*)realloc(a->r_j, a->size * sizeof(int));
+		a->r_k = (int*)realloc(a->r_k, a->size * sizeof(int));
+		a->type = (int*)realloc(a->type, a->size * sizeof(int));
+		a->delay = (int*)realloc(a->delay, a->size * sizeof(int));
+		a->remain = (int*)realloc(a->remain, a->size * sizeof(int));
+		a->index = (int*)realloc(a->index, a->size * sizeof(int));
+		a->unit = (int*)realloc(a->unit, a->size * sizeof(int));
+		a->next_read = (int*)realloc(a->next_read, a->size * sizeof(int));
+		a->result = (float*)realloc(a->result, a->size * sizeof(float));
+		a->inst_ptr = (Inst**)realloc(a->inst_ptr, a->size * sizeof(Inst*));
+		a->inst_idx = (int*)realloc(a->inst_idx, a->size * sizeof(int));
+		a->waw_flag = (int*)realloc(a->waw_flag, a->size * sizeof(int));
+		a->v_j = (float*)realloc(a->v_j, a->size * sizeof(float));
+		a->v_k = (float*)realloc(a->v_k, a->size * sizeof(float));
+		a->busy_cycles = (long long*)realloc(a->busy_cycles, a->size * sizeof(long long));
+	}
+	u = (int)a->used;
+	if (u % 32 == 0) { // Another word of waiters masks for every register, and of the active bitmask
+		a->waiters = (unsigned int*)realloc(a->waiters, (u / 32 + 1) * REGS_NUM * sizeof(unsigned int));
+		memset(&a->waiters[(u / 32) * REGS_NUM], 0, REGS_NUM * sizeof(unsigned int));
+		a->active = (unsigned int*)realloc(a->active, (u / 32 + 1) * sizeof(unsigned int));
+		a->active[u / 32] = 0;
+	}
+	if (a->count[type] == 0) {
+		a->first[type] = u;
+	}
+	reset_unit(a, u);
+	a->type[u] = type;
+	a->delay[u] = delay;
+	a->busy_cycles[u] = 0;
+	a->index[u] = a->count[type];
+	a->unit[u] = unit;
+	a->next_read[u] = 0;
+	a->count[type]++;
+
+	a->used++;
+}
+
+// Initializing an empty memory with an address space of 2^addr_bits words (MEM_ADDR_BITS..32), no page is allocated until it is written
+void init_mem(Sim_mem *mem, int addr_bits)
+{
+	mem->addr_mask = addr_bits >= 32 ? 0xFFFFFFFFu : (1u << addr_bits) - 1;
+	mem->tables_num = addr_bits > PAGE_BITS + TABLE_BITS ? 1u << (addr_bits - PAGE_BITS - TABLE_BITS) : 1;
+	mem->tables = (Mem_page***)calloc(mem->tables_num, sizeof(Mem_page**));
+}
+
+// Allocates a page of zero words
+Mem_page *newPage(void)
+{
+	Mem_page *page = (Mem_page*)calloc(1, sizeof(Mem_page) + PAGE_WORDS * sizeof(int));
+	page->words = (int*)(page + 1);
+	return page;
+}
+
+// Free the memory pages and tables, and unmaps the memin image
+void free_mem(Sim_mem *mem)
+{
+	unsigned int t, p;
+	for (t = 0; t < mem->tables_num; t++) {
+		if (mem->tables[t] != NULL) {
+			for (p = 0; p < TABLE_PAGES; p++) {
+				free(mem->tables[t][p]);
+			}
+			free(mem->tables[t]);
+		}
+	}
+	free(mem->tables);
+	if (mem->image != NULL) {
+#ifdef _WIN32
+		UnmapViewOfFile(mem->image);
+#else
+		munmap(mem->image, mem->image_len);
+#endif
+	}
+	memset(mem, 0, sizeof(Sim_mem));
+}
+
+// Returns the page of the input address, NULL if it was never written.
+Mem_page *memPage(Sim_mem *mem, unsigned int addr)
+{
+	Mem_page **table;
+	addr &= mem->addr_mask;
+	table = mem->tables[addr >> (PAGE_BITS + TABLE_BITS)];
+	return table == NULL ? NULL : table[(addr >> PAGE_BITS) & (TABLE_PAGES - 1)];
+}
+
+// Returns the page of the input address, allocating it and its table if needed.
+Mem_page *memAllocPage(Sim_mem *mem, unsigned int addr)
+{
+	Mem_page **table;
+	Mem_page **page;
+	addr &= mem->addr_mask;
+	table = mem->tables[addr >> (PAGE_BITS + TABLE_BITS)];
+	if (table == NULL) {
+		table = (Mem_page**)calloc(TABLE_PAGES, sizeof(Mem_page*));
+		mem->tables[addr >> (PAGE_BITS + TABLE_BITS)] = table;
+	}
+	page = &table[(addr >> PAGE_BITS) & (TABLE_PAGES - 1)];
+	if (*page == NULL) {
+		*page = newPage();
+	}
+	return *page;
+}
+
+// Reads a word of the memory, a word that was never written is 0.
+int memRead(Sim_mem *mem, unsigned int addr)
+{
+	Mem_page *page = memPage(mem, addr);
+	return page == NULL ? 0 : page->words[addr & (PAGE_WORDS - 1)];
+}
+
+// Writes a word of the memory. A store marks the word dirty, initial memory isn't.
+void memWrite(Sim_mem *mem, unsigned int addr, int value, int is_store)
+{
+	Mem_page *page;
+	if (value == 0 && !is_store && memPage(mem, addr) == NULL) { // Already 0, the page is still not needed
+		return;
+	}
+	page = memAllocPage(mem, addr);
+	page->words[addr & (PAGE_WORDS - 1)] = value;
+	if (is_store) {
+		page->dirty[(addr & (PAGE_WORDS - 1)) / 32] |= 1u << (addr % 32);
+	}
+}
+
+// Copies the memory src into the empty memory dst, page by page. The pages of dst are all its own, even if src is mapped.
+void memCopy(Sim_mem *dst, Sim_mem *src)
+{
+	unsigned int t, p;
+	*dst = *src;
+	dst->image = NULL;
+	dst->image_len = 0;
+	dst->tables = (Mem_page***)calloc(src->tables_num, sizeof(Mem_page**));
+	for (t = 0; t < src->tables_num; t++) {
+		if (src->tables[t] != NULL) {
+			dst->tables[t] = (Mem_page**)calloc(TABLE_PAGES, sizeof(Mem_page*));
+			for (p = 0; p < TABLE_PAGES; p++) {
+				if (src->tables[t][p] != NULL) {
+					dst->tables[t][p] = newPage();
+					memcpy(dst->tables[t][p]->words, src->tables[t][p]->words, PAGE_WORDS * sizeof(int));
+					memcpy(dst->tables[t][p]->dirty, src->tables[t][p]->dirty, sizeof(src->tables[t][p]->dirty));
+				}
+			}
+		}
+	}
+}
+
+// Returns the number of pages of a full memory dump: up to the last allocated page, and at least MEM_LENGTH_SIM words.
+unsigned int memDumpPages(Sim_mem *mem)
+{
+	unsigned int t, p, pages = MEM_LENGTH_SIM / PAGE_WORDS;
+	for (t = 0; t < mem->tables_num; t++) {
+		if (mem->tables[t] != NULL) {
+			for (p = 0; p < TABLE_PAGES; p++) {
+				if (mem->tables[t][p] != NULL && (t << TABLE_BITS) + p + 1 > pages) {
+					pages = (t << TABLE_BITS) + p + 1;
+				}
+			}
+		}
+	}
+	return pages;
+}
+
+/*
+	Single precision (IEEE-754) conversions between a memory word and a float, bit exact by copying the bits.
+*/
+float single_pre_to_float(unsigned int sp) {
+	float res;
+	memcpy(&res, &sp, sizeof(res));
+	return res;
+}
+int floatToSinglePre(float f) {
+	int res;
+	memcpy(&res, &f, sizeof(res));
+	return res;
+}
+
+/*
+	The original conversions, kept for the legacy_float cfg flag to reproduce old outputs.
+	They were only right for 1.0 <= |value| < 2^24. A load of a smaller value (or of inf and nan) gave inf,
+	and a store of a value below 1.0 gave the x86 results of the original code, where the out of range conversions to int gives INT_MIN
+	and the shift counts are taken mod 32: values in [0, 1) stores as 1.0, 0 and negative values stores as -1.0.
+*/
+float single_pre_to_float_legacy(unsigned int sp) {
+	unsigned int sign = sp >> 31, exp = (sp >> 23) & 0xFF;
+	if (sp == 0) {
+		return 0.0;
+	}
+	if (exp < 127 || exp == 255) {
+		return sign ? -INFINITY : INFINITY;
+	}
+	return single_pre_to_float(sp);
+}
+int floatToSinglePre_legacy(float f) {
+	unsigned int sign, exp, fra, fra_to_bit = 0;
+	int integer, exp_bit_len, i = 0;
+	double integer_fl = floor(f);
+	float rat;
+	integer = (integer_fl >= -2147483648.0 && integer_fl < 2147483648.0) ? (int)integer_fl : INT_MIN;
+	rat = f - integer;
+	sign = f > 0.0 ? 0 : 1;
+	exp_bit_len = integer > 0 ? (int)floor(log2(integer)) : INT_MIN;
+	exp = (unsigned int)exp_bit_len + 127;
+	fra = (unsigned int)integer << ((23 - (unsigned int)exp_bit_len) & 31);
+	for (i = 0; exp_bit_len >= 0 && i < (23 - exp_bit_len); i++) {
+		rat = rat * 2;
+		if (1 > rat) {
+			fra_to_bit <<= 1;
+		}
+		else {
+			fra_to_bit += 1;
+			fra_to_bit <<= 1;
+			rat -= 1;
+		}
+	}
+	fra_to_bit >>= 1;
+	fra = fra | fra_to_bit;
+	fra = fra & 0x7FFFFF;
+
+	return (int)((((sign << 8) + exp) << 23) + fra);
+}
+
+/*
+	Converts a whole memory image of n words to floats, and back.
+*/
+void memToFloats(const int *MEM, float *floats, int n, int legacy_float) {
+	int i;
+	if (legacy_float) {
+		for (i = 0; i < n; i++) {
+			floats[i] = single_pre_to_float_legacy(MEM[i]);
+		}
+	}
+	else {
+		memcpy(floats, MEM, n * sizeof(float));
+	}
+}
+void floatsToMem(const float *floats, int *MEM, int n, int legacy_float) {
+	int i;
+	if (legacy_float) {
+		for (i = 0; i < n; i++) {
+			MEM[i] = floatToSinglePre_legacy(floats[i]);
+		}
+	}
+	else {
+		memcpy(MEM, floats, n * sizeof(float));
+	}
+}
+/*
+	Config file.
+	Each line is "key = value", blank lines and lines starting with '#' are skipped. The file is read in a single pass into a Run_cfg,
+	keys are matched whole and values are checked, an unknown key or a bad value is reported with its line and fails the parsing.
+	The units number and delay of every type are required, the rest of the keys have defaults.
+*/
+typedef struct {
+	// Units numbers and delays, and the flags of the library config
+	Sim_config sim;
+
+	int memout_sparse;
+	int functional;
+	int sample_period;
+	int sample_warmup;
+	int sample_window;
+	// Flag to also run the whole program in detail after a sampled run, and print how far off the estimate was
+	int sample_check;
+
+	// Clock cycle to checkpoint at, -1 for halt, 0 for none. See saveCheckpoint.
+	int checkpoint_at;
+	char checkpoint_file[MAX_LINE_LENGTH];
+	char restore_from[MAX_LINE_LENGTH];
+
+	// Units to trace and the traced cycles window, see getTraceUnits
+	char trace_unit[MAX_LINE_LENGTH];
+	int trace_from;
+	int trace_to;
+
+	// File to write the run statistics to, see writeStats. Only the cycle model (not functional or sampled) writes it.
+	char stats_file[MAX_LINE_LENGTH];
+} Run_cfg;
+
+// Kinds of cfg values
+#define CFG_INT    0
+#define CFG_STRING 1
+// A clock cycle or "halt" (-1)
+#define CFG_CYCLE  2
+// A cache replacement policy name, see cache_policies
+#define CFG_POLICY 3
+
+// Names of the cache replacement policies, indexed by CACHE_LRU, CACHE_FIFO and CACHE_RANDOM
+static const char *cache_policies[3] = { "lru", "fifo", "random" };
+
+typedef struct {
+	const char *key;
+	int kind;
+	size_t offset;
+	// Range of an integer value
+	int min;
+	int max;
+	// 1 for a key of the library config (Run_cfg.sim), see checkSimConfig
+	int sim;
+} Cfg_key;
+
+// The first 12 keys are the required units numbers and delays.
+static Cfg_key cfg_keys[] = {
+	{ "ld_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_LD]), 1, INT_MAX, 1 },
+	{ "st_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_ST]), 1, INT_MAX, 1 },
+	{ "add_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_ADD]), 1, INT_MAX, 1 },
+	{ "sub_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_SUB]), 1, INT_MAX, 1 },
+	{ "mul_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_MULT]), 1, INT_MAX, 1 },
+	{ "div_nr_units", CFG_INT, offsetof(Run_cfg, sim.units[OP_DIV]), 1, INT_MAX, 1 },
+	{ "ld_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_LD]), 1, INT_MAX, 1 },
+	{ "st_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_ST]), 1, INT_MAX, 1 },
+	{ "add_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_ADD]), 1, INT_MAX, 1 },
+	{ "sub_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_SUB]), 1, INT_MAX, 1 },
+	{ "mul_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_MULT]), 1, INT_MAX, 1 },
+	{ "div_delay", CFG_INT, offsetof(Run_cfg, sim.delays[OP_DIV]), 1, INT_MAX, 1 },
+	{ "mem_addr_bits", CFG_INT, offsetof(Run_cfg, sim.mem_addr_bits), MEM_ADDR_BITS, 32, 1 },
+	{ "mem_base_addressing", CFG_INT, offsetof(Run_cfg, sim.base_addressing), 0, 1, 1 },
+	{ "legacy_float", CFG_INT, offsetof(Run_cfg, sim.legacy_float), 0, 1, 1 },
+	{ "event_driven", CFG_INT, offsetof(Run_cfg, sim.event_driven), 0, 1, 1 },
+	{ "tomasulo", CFG_INT, offsetof(Run_cfg, sim.tomasulo), 0, 1, 1 },
+	{ "mem_disambiguation", CFG_INT, offsetof(Run_cfg, sim.mem_disambiguation), 0, 1, 1 },
+	{ "fetch_width", CFG_INT, offsetof(Run_cfg, sim.fetch_width), 1, QUEUE_DEPTH_MAX, 1 },
+	{ "issue_width", CFG_INT, offsetof(Run_cfg, sim.issue_width), 1, QUEUE_DEPTH_MAX, 1 },
+	{ "queue_depth", CFG_INT, offsetof(Run_cfg, sim.queue_depth), 1, QUEUE_DEPTH_MAX, 1 },
+	{ "ld_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_LD]), 0, 1, 1 },
+	{ "st_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_ST]), 0, 1, 1 },
+	{ "add_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_ADD]), 0, 1, 1 },
+	{ "sub_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_SUB]), 0, 1, 1 },
+	{ "mul_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_MULT]), 0, 1, 1 },
+	{ "div_pipelined", CFG_INT, offsetof(Run_cfg, sim.pipelined[OP_DIV]), 0, 1, 1 },
+	{ "ld_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_LD]), 1, INT_MAX, 1 },
+	{ "st_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_ST]), 1, INT_MAX, 1 },
+	{ "add_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_ADD]), 1, INT_MAX, 1 },
+	{ "sub_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_SUB]), 1, INT_MAX, 1 },
+	{ "mul_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_MULT]), 1, INT_MAX, 1 },
+	{ "div_ii", CFG_INT, offsetof(Run_cfg, sim.ii[OP_DIV]), 1, INT_MAX, 1 },
+	{ "cache_size", CFG_INT, offsetof(Run_cfg, sim.cache_size), 0, INT_MAX, 1 },
+	{ "cache_line", CFG_INT, offsetof(Run_cfg, sim.cache_line), 1, INT_MAX, 1 },
+	{ "cache_ways", CFG_INT, offsetof(Run_cfg, sim.cache_ways), 1, INT_MAX, 1 },
+	{ "cache_policy", CFG_POLICY, offsetof(Run_cfg, sim.cache_policy), 0, 0, 1 },
+	{ "cache_hit_delay", CFG_INT, offsetof(Run_cfg, sim.cache_hit_delay), 1, INT_MAX, 1 },
+	{ "cache_miss_delay", CFG_INT, offsetof(Run_cfg, sim.cache_miss_delay), 0, INT_MAX, 1 },
+	{ "memout_sparse", CFG_INT, offsetof(Run_cfg, memout_sparse), 0, 1, 0 },
+	{ "functional", CFG_INT, offsetof(Run_cfg, functional), 0, 1, 0 },
+	{ "sample_period", CFG_INT, offsetof(Run_cfg, sample_period), 0, INT_MAX, 0 },
+	{ "sample_warmup", CFG_INT, offsetof(Run_cfg, sample_warmup), 0, INT_MAX, 0 },
+	{ "sample_window", CFG_INT, offsetof(Run_cfg, sample_window), 0, INT_MAX, 0 },
+	{ "sample_check", CFG_INT, offsetof(Run_cfg, sample_check), 0, 1, 0 },
+	{ "checkpoint_at", CFG_CYCLE, offsetof(Run_cfg, checkpoint_at), 1, INT_MAX, 0 },
+	{ "checkpoint_file", CFG_STRING, offsetof(Run_cfg, checkpoint_file), 0, 0, 0 },
+	{ "restore_from", CFG_STRING, offsetof(Run_cfg, restore_from), 0, 0, 0 },
+	{ "trace_unit", CFG_STRING, offsetof(Run_cfg, trace_unit), 0, 0, 0 },
+	{ "trace_from", CFG_INT, offsetof(Run_cfg, trace_from), 0, INT_MAX, 0 },
+	{ "trace_to", CFG_INT, offsetof(Run_cfg, trace_to), 0, INT_MAX, 0 },
+	{ "stats_file", CFG_STRING, offsetof(Run_cfg, stats_file), 0, 0, 0 },
+};
+
+#define CFG_KEYS_NUM ((int)(sizeof(cfg_keys) / sizeof(cfg_keys[0])))
+#define CFG_UNIT_KEYS 12
+
+// Sets the defaults of the keys that are not required.
+void initRunCfg(Run_cfg *cfg) {
+	int i;
+	memset(cfg, 0, sizeof(Run_cfg));
+	for (i = 0; i < 6; i++) {
+		cfg->sim.ii[i] = 1;
+	}
+	cfg->sim.mem_addr_bits = MEM_ADDR_BITS;
+	cfg->sim.fetch_width = 1;
+	cfg->sim.issue_width = 1;
+	cfg->sim.queue_depth = QUEUE_DEPTH;
+	cfg->sim.cache_line = CACHE_LINE;
+	cfg->sim.cache_ways = 1;
+	cfg->sim.cache_hit_delay = 1;
+	cfg->trace_to = INT_MAX;
+}
+
+/*
+	Splits a cfg line in place into its key and value, without the white spaces around them.
+	Returns 0 for a blank or comment line, -1 if the line has no '=' or no key.
+*/
+int splitCfgLine(char *line, char **key, char **value) {
+	char *eq, *end;
+	while (isspace((unsigned char)*line)) {
+		line++;
+	}
+	if (*line == '\0' || *line == '#') {
+		return 0;
+	}
+	eq = strchr(line, '=');
+	if (eq == NULL || eq == line) {
+		return -1;
+	}
+	for (end = eq; end > line && isspace((unsigned char)end[-1]); end--);
+	*end = '\0';
+	*key = line;
+	line = eq + 1;
+	while (isspace((unsigned char)*line)) {
+		line++;
+	}
+	for (end = line + strlen(line); end > line && isspace((unsigned char)end[-1]); end--);
+	*end = '\0';
+	*value = line;
+	return 1;
+}
+
+// Returns the index of the key in the keys table, -1 if it is unknown.
+int findCfgKey(const Cfg_key *keys, int keys_num, const char *key) {
+	int k;
+	for (k = 0; k < keys_num && strcmp(keys[k].key, key) != 0; k++);
+	return k < keys_num ? k : -1;
+}
+
+/*
+	Sets the value of the key in the struct its offset is in (a Run_cfg for cfg_keys).
+	Returns 0 if the value is not valid for the key.
+*/
+int setCfgValue(void *base, const Cfg_key *key, char *value) {
+	char *field = (char*)base + key->offset;
+	char *end;
+	long num;
+
+	if (key->kind == CFG_STRING) {
+		if (strlen(value) >= MAX_LINE_LENGTH) {
+			return 0;
+		}
+		strcpy(field, value);
+		return 1;
+	}
+	if (key->kind == CFG_CYCLE && strcmp(value, "halt") == 0) {
+		*(int*)field = -1;
+		return 1;
+	}
+	if (key->kind == CFG_POLICY) {
+		for (num = 0; num < 3 && strcmp(value, cache_policies[num]) != 0; num++);
+		*(int*)field = (int)num;
+		return num < 3;
+	}
+	errno = 0;
+	num = strtol(value, &end, 10);
+	if (end == value || *end != '\0' || errno == ERANGE || num < key->min || num > key->max) {
+		return 0;
+	}
+	*(int*)field = (int)num;
+	return 1;
+}
+
+/*
+	Parses a file of "key = value" lines into the struct of the keys table, in a single pass.
+	Errors are printed with the line they are at. found[k] is set for each key k of the file, if found isn't NULL.
+	Returns 0 if the file couldn't be read or has an error.
+*/
+int parseKeysFile(char *path, const Cfg_key *keys, int keys_num, void *base, char *found) {
+	FILE *file;
+	char line[BUF_SIZE];
+	char *key, *value;
+	int k, line_num = 0, ok = 1;
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		printf("couldn't open the file %s\n", path);
+		return 0;
+	}
+	while (fgets(line, BUF_SIZE, file) != NULL) {
+		line_num++;
+		switch (splitCfgLine(line, &key, &value)) {
+		case 0:
+			continue;
+		case -1:
+			printf("%s:%d: expected \"key = value\"\n", path, line_num);
+			ok = 0;
+			continue;
+		}
+		k = findCfgKey(keys, keys_num, key);
+		if (k == -1) {
+			printf("%s:%d: unknown key %s\n", path, line_num, key);
+			ok = 0;
+			continue;
+		}
+		if (found != NULL) {
+			found[k] = 1;
+		}
+		if (!setCfgValue(base, &keys[k], value)) {
+			printf("%s:%d: invalid value \"%s\" of %s\n", path, line_num, value, key);
+			ok = 0;
+		}
+	}
+	fclose(file);
+	return ok;
+}
+
+// Returns 0 if the cache of the config can't be split into sets of ways lines, errors are printed.
+int checkCacheConfig(const Sim_config *cfg) {
+	if (cfg->cache_size == 0) {
+		return 1;
+	}
+	if (cfg->cache_size < 0 || cfg->cache_line < 1 || cfg->cache_ways < 1 || cfg->cache_size % cfg->cache_line != 0 ||
+		cfg->cache_size / cfg->cache_line % cfg->cache_ways != 0) {
+		printf("cache_size must be a multiple of cache_line * cache_ways\n");
+		return 0;
+	}
+	if (cfg->cache_policy < CACHE_LRU || cfg->cache_policy > CACHE_RANDOM || cfg->cache_hit_delay < 1 || cfg->cache_miss_delay < 0) {
+		printf("invalid cache_policy or cache delays\n");
+		return 0;
+	}
+	return 1;
+}
+
+/*
+	Checks the values of a library config against the ranges of their cfg keys, like a parsed cfg file.
+	Returns 0 if a value is out of its range or the cache is invalid, errors are printed.
+*/
+int checkSimConfig(const Sim_config *cfg) {
+	size_t offset;
+	int k, value;
+	for (k = 0; k < CFG_KEYS_NUM; k++) {
+		if (!cfg_keys[k].sim || cfg_keys[k].kind != CFG_INT) {
+			continue;
+		}
+		offset = cfg_keys[k].offset - offsetof(Run_cfg, sim);
+		value = *(const int*)((const char*)cfg + offset);
+		if (value < cfg_keys[k].min || value > cfg_keys[k].max) {
+			printf("%s must be between %d and %d\n", cfg_keys[k].key, cfg_keys[k].min, cfg_keys[k].max);
+			return 0;
+		}
+	}
+	return checkCacheConfig(cfg);
+}
+
+/*
+	Parses the cfg file into the config.
+	Returns 0 if the file couldn't be read, has an error or misses a required key.
+*/
+int parseCfg(char *cfg_path, Run_cfg *cfg) {
+	char found[CFG_KEYS_NUM] = { 0 };
+	int k, ok;
+
+	initRunCfg(cfg);
+	ok = parseKeysFile(cfg_path, cfg_keys, CFG_KEYS_NUM, cfg, found);
+	for (k = 0; k < CFG_UNIT_KEYS; k++) {
+		if (!found[k]) {
+			printf("%s: missing %s\n", cfg_path, cfg_keys[k].key);
+			ok = 0;
+		}
+	}
+	return ok && checkCacheConfig(&cfg->sim);
+}
+
+/*
+	Parsed configs of a batch, each cfg file is parsed once for all of the jobs that use it.
+*/
+typedef struct {
+	char (*paths)[MAX_LINE_LENGTH];
+	Run_cfg *cfgs;
+	// 0 if the cfg file failed to parse
+	char *valid;
+	int num;
+	int size;
+} Cfg_cache;
+
+/*
+	Returns the index in the cache of the parsed config of the cfg file, parsing it if it is not in the cache yet.
+	The index stays valid as the cache grows, unlike a pointer.
+	Returns -1 if the cfg file failed to parse, its errors are printed only the first time.
+*/
+int getCachedCfg(Cfg_cache *cache, char *cfg_path) {
+	int i;
+	for (i = cache->num - 1; i >= 0; i--) { // Jobs of the same cfg are usually next to each other
+		if (strcmp(cache->paths[i], cfg_path) == 0) {
+			return cache->valid[i] ? i : -1;
+		}
+	}
+	if (cache->num == cache->size) {
+		cache->size = cache->size == 0 ? 8 : 2 * cache->size;
+		cache->paths = realloc(cache->paths, cache->size * sizeof(*cache->paths));
+		cache->cfgs = (Run_cfg*)realloc(cache->cfgs, cache->size * sizeof(Run_cfg));
+		cache->valid = (char*)realloc(cache->valid, cache->size);
+	}
+	i = cache->num++;
+	strcpy(cache->paths[i], cfg_path);
+	cache->valid[i] = (char)parseCfg(cfg_path, &cache->cfgs[i]);
+	return cache->valid[i] ? i : -1;
+}
+
+void freeCfgCache(Cfg_cache *cache) {
+	free(cache->paths);
+	free(cache->cfgs);
+	free(cache->valid);
+	memset(cache, 0, sizeof(Cfg_cache));
+}
+
+/*
+	Reads the units to trace of the config into the trace set.
+	trace_unit is a list separated by commas or spaces of units (ADD0), all of the units of a type (MUL*) or ALL.
+	trace_from and trace_to limit the traced cycles to a window.
+	Returns the number of traced units, units that don't exist are reported and left out.
+*/
+int getTraceUnits(Run_cfg *cfg, Unit_table *fu, Trace_set *set) {
+	char name[8];
+	char *pos;
+	int words = ((int)fu->used + 31) / 32;
+	int type, index, len, u, traced = 0, first, last;
+
+	set->units = (unsigned int*)calloc(words > 0 ? words : 1, sizeof(unsigned int));
+	set->from = cfg->trace_from;
+	set->to = cfg->trace_to;
+
+	pos = cfg->trace_unit;
+	while (*pos != '\0') {
+		if (*pos == ',' || isspace((unsigned char)*pos)) {
+			pos++;
+			continue;
+		}
+		// Unit type name, or ALL
+		for (len = 0; isalpha((unsigned char)*pos); pos++) {
+			if (len < 7) {
+				name[len++] = (char)toupper((unsigned char)*pos);
+			}
+		}
+		name[len] = '\0';
+		index = -1;
+		if (strcmp(name, "ALL") == 0) {
+			first = 0;
+			last = (int)fu->used;
+		}
+		else {
+			for (type = 0; type < 6 && strcmp(name, units_names[type]) != 0; type++);
+			if (type == 6) {
+				printf("unknown trace unit type %s\n", name);
+				while (*pos != '\0' && *pos != ',' && !isspace((unsigned char)*pos)) {
+					pos++;
+				}
+				continue;
+			}
+			first = fu->first[type];
+			last = fu->first[type] + fu->count[type];
+			if (*pos == '*') {
+				pos++;
+			}
+			else {
+				index = 0;
+				for (; isdigit((unsigned char)*pos); pos++) {
+					index = index * 10 + (*pos - '0');
+				}
+				if (index >= fu->units[type]) {
+					printf("trace unit %s%d doesn't exist\n", name, index);
+					continue;
+				}
+			}
+		}
+		for (u = first; u < last; u++) {
+			if (index != -1 && fu->unit[u] != index) { // Only the slots of the named unit
+				continue;
+			}
+			if (!(set->units[u / 32] & (1u << (u % 32)))) {
+				set->units[u / 32] |= 1u << (u % 32);
+				traced++;
+			}
+		}
+	}
+	return traced;
+}
+
+/*
+	Gets and instruction value as int and the queue, "fetching" the instucrion to the tail of the queue if there is an free space.
+*/
+int fetch(Inst_queue *iq, int inst) {
+	if (iq->tail - iq->head < iq->size) {
+		iq->q[iq->tail % iq->size] = createInst(inst);
+		iq->tail++;
+		return 1;
+	}
+
+	return 0;
+}
+
+// Number of instructions in the queue ahead of the one in the input slot, the older instruction has the smaller age.
+int queueAge(Inst_queue *iq, int slot) {
+	return (slot - iq->head % iq->size + iq->size) % iq->size;
+}
+
+// Returns the lowest free unit of the input type, -1 if there is none.
+int findFreeUnit(Unit_table *fu, int type) {
+	int u = -1, w, first = fu->first[type], last = fu->first[type] + fu->count[type];
+	unsigned int free_units;
+	if (fu->count[type] == 0) {
+		return -1;
+	}
+	// The free units of the type are the clear active bits in its range
+	for (w = first / 32; w <= (last - 1) / 32 && u == -1; w++) {
+		free_units = ~fu->active[w];
+		if (w == first / 32) {
+			free_units &= ~0u << (first % 32);
+		}
+		if (w == (last - 1) / 32 && last % 32 != 0) {
+			free_units &= ~0u >> (32 - last % 32);
+		}
+		if (free_units) {
+			u = w * 32 + lowestBit(free_units);
+		}
+	}
+	return u;
+}
+
+// Converts a base register value to an address, negative values wrap around the address space and invalid ones are 0.
+unsigned int floatToAddr(float f) {
+	if (f >= 0 && f < 4294967296.0f) {
+		return (unsigned int)f;
+	}
+	if (f < 0 && f > -2147483648.0f) {
+		return (unsigned int)(int)f;
+	}
+	return 0;
+}
+
+// Gets the memory address of a Tomasulo LD/ST unit. Returns 0 if it is not known yet, when its base register value wasn't captured.
+int tomAddr(Unit_table * fu, int u, Inst *inst, unsigned int *addr) {
+	if (!fu->base_addressing) {
+		*addr = inst->addr;
+		return 1;
+	}
+	if (fu->r_j[u] != 1) {
+		return 0;
+	}
+	*addr = (unsigned int)inst->imm + floatToAddr(fu->v_j[u]);
+	return 1;
+}
+
+// Creates the memory dependence table of the units, once all of them were inserted.
+void initMemDeps(Unit_table *fu, int tomasulo) {
+	Mem_deps *deps = (Mem_deps*)calloc(1, sizeof(Mem_deps));
+	unsigned int lists = 16, i;
+	// Twice the lists of the LD/ST units keeps the lists short
+	while (lists < 2 * (unsigned int)(fu->count[OP_LD] + fu->count[OP_ST])) {
+		lists *= 2;
+	}
+	deps->heads = (int*)malloc(lists * sizeof(int));
+	for (i = 0; i < lists; i++) {
+		deps->heads[i] = -1;
+	}
+	deps->mask = lists - 1;
+	deps->unknown = -1;
+	deps->next = (int*)malloc((fu->used + 1) * sizeof(int));
+	deps->addr = (unsigned int*)calloc(fu->used + 1, sizeof(unsigned int));
+	for (i = 0; i < fu->used; i++) {
+		deps->next[i] = -2;
+	}
+	deps->tomasulo = tomasulo;
+	fu->deps = deps;
+}
+
+// Gets the address of a busy LD/ST unit, known by the scoreboard once the unit read its operands. Returns 0 if it is not known yet.
+int depsUnitAddr(Unit_table *fu, int u, unsigned int *addr) {
+	if (fu->deps->tomasulo) {
+		return tomAddr(fu, u, fu->inst_ptr[u], addr);
+	}
+	if (fu->base_addressing && fu->inst_ptr[u]->read == -1) {
+		return 0;
+	}
+	*addr = fu->inst_ptr[u]->addr;
+	return 1;
+}
+
+// Lists a LD/ST unit once it is issued, by its address or in the unknown list.
+void depsInsert(Unit_table *fu, int u) {
+	Mem_deps *deps = fu->deps;
+	int *head = &deps->unknown;
+	if (depsUnitAddr(fu, u, &deps->addr[u])) {
+		head = &deps->heads[deps->addr[u] & deps->mask];
+	}
+	deps->next[u] = *head;
+	*head = u;
+}
+
+// Removes a LD/ST unit from its list once it is done.
+void depsRemove(Unit_table *fu, int u) {
+	Mem_deps *deps = fu->deps;
+	int *link;
+	if (deps->next[u] == -2) {
+		return;
+	}
+	for (link = &deps->unknown; *link != -1 && *link != u; link = &deps->next[*link]);
+	if (*link == -1) {
+		for (link = &deps->heads[deps->addr[u] & deps->mask]; *link != u; link = &deps->next[*link]);
+	}
+	*link = deps->next[u];
+	deps->next[u] = -2;
+}
+
+// Moves the units of the unknown list whose address got known to the lists of their addresses.
+void depsResolve(Unit_table *fu) {
+	Mem_deps *deps = fu->deps;
+	int *link = &deps->unknown, u;
+	while (*link != -1) {
+		u = *link;
+		if (!depsUnitAddr(fu, u, &deps->addr[u])) {
+			link = &deps->next[u];
+			continue;
+		}
+		*link = deps->next[u];
+		deps->next[u] = deps->heads[deps->addr[u] & deps->mask];
+		deps->heads[deps->addr[u] & deps->mask] = u;
+	}
+}
+
+// Whether a listed LD/ST unit accessed the memory already. A store writes it when it completes, a scoreboard load reads it
+// when it starts executing and a Tomasulo load when it completes.
+int depsAccessed(Unit_table *fu, int u) {
+	if (fu->type[u] == OP_LD && !fu->deps->tomasulo) {
+		return fu->result[u] != -1;
+	}
+	return fu->inst_ptr[u]->exec != -1;
+}
+
+/*
+	Checks the earlier LD/ST units of the same address as the unit u (or of an address not known yet) that didn't access the memory yet.
+	The Tomasulo engine keeps them in order: a store waits for all of them, and a load for the stores, but the youngest store of its
+	address forwards its data to the load once it has it, unless a store of an unknown address is younger.
+	The scoreboard loads pass the earlier stores like without the table, the youngest store of the address only forwards its data
+	if it has it already, and a store only waits for the loads.
+	The forwarding store is returned through store, -1 if the load reads the memory. Returns the stall cause, -1 if the unit may go on.
+*/
+int depsHazard(Unit_table *fu, Inst_queue *iq, int u, int *store) {
+	Mem_deps *deps = fu->deps;
+	int age, v_age, store_age = -1, cause = -1, v;
+	depsResolve(fu);
+	age = queueAge(iq, fu->inst_idx[u]);
+	*store = -1;
+	for (v = deps->heads[deps->addr[u] & deps->mask]; v != -1; v = deps->next[v]) {
+		v_age = queueAge(iq, fu->inst_idx[v]);
+		if (deps->addr[v] != deps->addr[u] || v_age >= age || depsAccessed(fu, v)) {
+			continue;
+		}
+		if (fu->type[u] == OP_ST) {
+			if (fu->type[v] == OP_LD) {
+				cause = STALL_WAR;
+			}
+			else if (deps->tomasulo && cause == -1) {
+				cause = STALL_WAW;
+			}
+		}
+		else if (fu->type[v] == OP_ST && v_age > store_age) {
+			*store = v;
+			store_age = v_age;
+		}
+	}
+	for (v = deps->unknown; v != -1; v = deps->next[v]) {
+		v_age = queueAge(iq, fu->inst_idx[v]);
+		if (v_age >= age) {
+			continue;
+		}
+		if (fu->type[u] == OP_ST) {
+			if (fu->type[v] == OP_LD) {
+				cause = STALL_WAR;
+			}
+			else if (deps->tomasulo && cause == -1) {
+				cause = STALL_WAW;
+			}
+		}
+		else if (deps->tomasulo && fu->type[v] == OP_ST && v_age > store_age) {
+			return STALL_RAW;
+		}
+	}
+	if (*store != -1 && !(deps->tomasulo ? fu->r_k[*store] == 1 : fu->result[*store] != -1)) {
+		if (!deps->tomasulo) {
+			*store = -1;
+			return -1;
+		}
+		return STALL_RAW;
+	}
+	return cause;
+}
+
+// Creates the data cache of the LD/ST units, empty.
+void initDataCache(Unit_table *fu, const Sim_config *cfg) {
+	Data_cache *cache = (Data_cache*)calloc(1, sizeof(Data_cache));
+	int lines = cfg->cache_size / cfg->cache_line;
+	cache->ways = cfg->cache_ways;
+	cache->sets = lines / cfg->cache_ways;
+	cache->line = cfg->cache_line;
+	cache->policy = cfg->cache_policy;
+	cache->hit_delay = cfg->cache_hit_delay;
+	cache->miss_delay = cfg->cache_miss_delay;
+	cache->tags = (unsigned int*)calloc(lines, sizeof(unsigned int));
+	cache->flags = (unsigned char*)calloc(lines, sizeof(unsigned char));
+	cache->stamps = (unsigned long long*)calloc(lines, sizeof(unsigned long long));
+	cache->seed = 1;
+	fu->cache = cache;
+}
+
+/*
+	Looks up the line of the address, and fills it on a miss in place of an invalid line of its set or else of the line the policy picks.
+	Returns the delay of the access, delay is the delay of the unit.
+*/
+int cacheAccess(Data_cache *cache, unsigned int addr, int store, int delay) {
+	unsigned int tag = addr / (unsigned int)cache->line;
+	int first = (int)(tag % (unsigned int)cache->sets) * cache->ways, end = first + cache->ways, l, victim = first;
+
+	cache->accesses++;
+	for (l = first; l < end; l++) {
+		if ((cache->flags[l] & CACHE_VALID) && cache->tags[l] == tag) {
+			cache->hits[store]++;
+			cache->flags[l] |= store ? CACHE_DIRTY : 0;
+			if (cache->policy == CACHE_LRU) {
+				cache->stamps[l] = cache->accesses;
+			}
+			return cache->hit_delay;
+		}
+	}
+	cache->misses[store]++;
+	for (l = first; l < end && (cache->flags[l] & CACHE_VALID); l++) {
+		if (cache->stamps[l] < cache->stamps[victim]) {
+			victim = l;
+		}
+	}
+	if (l < end) {
+		victim = l;
+	}
+	else if (cache->policy == CACHE_RANDOM) {
+		cache->seed = cache->seed * 1103515245u + 12345u;
+		victim = first + (int)((cache->seed >> 16) % (unsigned int)cache->ways);
+	}
+	cache->write_backs += (cache->flags[victim] & CACHE_DIRTY) != 0;
+	cache->tags[victim] = tag;
+	cache->flags[victim] = CACHE_VALID | (store ? CACHE_DIRTY : 0);
+	cache->stamps[victim] = cache->accesses;
+	return cache->miss_delay > 0 ? cache->miss_delay : delay;
+}
+
+/*
+	Remaining execution cycles of a LD/ST that starts its access to the cache now.
+	A LD/ST completes the cycle after it read its operands at the earliest, so a delay of 1 is timed like a delay of 2 (as by tomExec).
+*/
+int cacheRemain(Unit_table *fu, int u, Inst *inst) {
+	int delay = cacheAccess(fu->cache, inst->addr, fu->type[u] == OP_ST, fu->delay[u]);
+	return delay > 1 ? delay - 1 : 1;
+}
+
+/*
+	Gets an instruction and issues that instruction to a free unit of the input type.
+	Setting all needed values for both the unit and the instruction elements
+*/
+int issueFuncUnitArr(int *busy_type, int *busy_idx, Unit_table * fu, int type, Inst *inst, int inst_idx) {
+	int u = findFreeUnit(fu, type);
+	if (u == -1) { // No free unit of this type
+		return 0;
+	}
+	fu->active[u / 32] |= 1u << (u % 32);
+	inst->unit_index = fu->unit[u];
+	fu->busy[u] = 1;
+	fu->f_i[u] = inst->dst;
+	fu->f_j[u] = inst->src0;
+	fu->f_k[u] = inst->src1;
+	if (-1 == busy_type[inst->src0]) {
+		fu->r_j[u] = 1; // src0 is not busy
+	}
+	else {
+		fu->r_j[u] = 0;
+		fu->waiters[(u / 32) * REGS_NUM + inst->src0] |= 1u << (u % 32);
+	}
+	if (-1 == busy_type[inst->src1]) {
+		fu->r_k[u] = 1; // src1 is not busy
+	}
+	else {
+		fu->r_k[u] = 0;
+		fu->waiters[(u / 32) * REGS_NUM + inst->src1] |= 1u << (u % 32);
+	}
+	fu->q_j_type[u] = busy_type[inst->src0];
+	fu->q_j_idx[u] = busy_idx[inst->src0];
+
+	fu->q_k_type[u] = busy_type[inst->src1];
+	fu->q_k_idx[u] = busy_idx[inst->src1];
+
+	if (busy_type[inst->dst] != -1) { // Some units is writing to the same dest
+		fu->waw_flag[u] = 1;
+	}
+	else {
+		busy_type[inst->dst] = fu->type[u];
+		busy_idx[inst->dst] = fu->index[u];
+	}
+	
+	fu->inst_ptr[u] = inst;
+	fu->inst_idx[u] = inst_idx;
+	if (fu->deps != NULL && (type == OP_LD || type == OP_ST)) {
+		depsInsert(fu, u);
+	}
+	return 1;
+}
+
+/*
+	Issues the upcoming instructions of the queue in order, up to width instructions while there are free units of their types.
+	Past the first instruction of the cycle a WAW hazard also stops the issue, an instruction with a busy dest register
+	is only issued as the first of its cycle, like a single issue scoreboard does.
+	The instructions of the same cycle see each other in the status arrays, so a RAW hazard between them waits in readOper.
+	Returns the number of instructions issued this cycle. A structural stall is counted into stalls if none was issued.
+*/
+int issue(int *busy_type, int *busy_idx, Inst_queue *iq, int cc, Unit_table * fu, int width, int *stalls) {
+	int issued = 0, slot;
+	Inst *inst;
+	while (issued < width && iq->next_issue != iq->tail) { // Up to the last fetched instruction
+		slot = iq->next_issue % iq->size;
+		inst = &iq->q[slot];
+		if (issued > 0 && busy_type[inst->dst] != -1) {
+			break;
+		}
+		if (inst->opcode < OP_LD || inst->opcode > OP_DIV || !issueFuncUnitArr(busy_type, busy_idx, fu, inst->opcode, inst, slot)) {
+			break;
+		}
+		inst->issue = cc;
+		iq->next_issue++;
+		issued++;
+	}
+	if (issued == 0 && iq->next_issue != iq->tail) {
+		stalls[STALL_STRUCT]++;
+	}
+	return issued;
+}
+
+/*
+	The following functions handle each step of the scoreboard algorithm, each one executes every cycle.
+	Each function goes over the active functional units in a single pass over the units table.
+	For every units it check if the handle can be exectued, the differences between the unit types are taken from the fu_* tables.
+	Each function returns 1 if it changed the simulator state this cycle, so main can tell the quiet cycles apart.
+*/
+/*
+	Records a unit that only counted down its remain this cycle.
+	next_event holds the smallest such remain, which is the number of cycles until the first of them completes.
+*/
+void noteCountdown(int *next_event, int remain) {
+	if (*next_event == -1 || remain < *next_event) {
+		*next_event = remain;
+	}
+}
+
+/*
+	Starts the pipeline of the unit if it is pipelined, for a unit that has its operands and may start its execution this cycle.
+	Returns 0 if the unit started another instruction less than ii cycles ago, that's a structural stall.
+*/
+int pipelineStart(Unit_table * fu, int u, int cc, int *next_start, int *stalls) {
+	int lead = unitLead(fu, u), ii = fu->ii[fu->type[u]];
+	if (ii == 0) {
+		return 1;
+	}
+	if (cc < fu->next_read[lead]) {
+		stalls[STALL_STRUCT]++;
+		noteCountdown(next_start, fu->next_read[lead] - cc);
+		return 0;
+	}
+	fu->next_read[lead] = cc + ii;
+	return 1;
+}
+
+/*
+	A pipelined unit that started an instruction less than ii cycles ago holds its other slots, the cycles until the first of them
+	may start are reported through next_start (-1 if there are none), like a countdown (see noteCountdown).
+*/
+int readOper(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_table * fu, int *next_start, int *stalls) {
+	int u = 0, type, changed = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	Inst *inst;
+	*next_start = -1;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			type = fu->type[u];
+			if (fu->inst_idx[u] == -1) {
+				continue;
+			}
+			inst = &q[fu->inst_idx[u]];
+			if (-1 == inst->issue || cc <= inst->issue || inst->read != -1) {
+				continue;
+			}
+			if ((needsJ(fu, type) && fu->r_j[u] != 1) || (fu_needs_k[type] && fu->r_k[u] != 1)) {
+				stalls[STALL_RAW]++;
+				continue;
+			}
+			if (fu_writes_reg[type]) {
+				if (fu->waw_flag[u]) {
+					if (busy_idx[fu->f_i[u]] == -1) { // This unit dest register is free (WAW)
+						busy_type[fu->f_i[u]] = type;
+						busy_idx[fu->f_i[u]] = fu->index[u];
+						changed = 1;
+					}
+				}
+				if (busy_idx[fu->f_i[u]] != -1 && (busy_idx[fu->f_i[u]] != fu->index[u] || busy_type[fu->f_i[u]] != type)) { // Another unit holds this unit dest register (WAW)
+					stalls[STALL_WAW]++;
+					continue;
+				}
+			}
+			if (!pipelineStart(fu, u, cc, next_start, stalls)) {
+				continue;
+			}
+			inst->read = cc;
+			if (fu->base_addressing && (type == OP_LD || type == OP_ST)) {
+				inst->addr = (unsigned int)inst->imm + floatToAddr(F[fu->f_j[u]]);
+			}
+			fu->remain[u] = fu->delay[u] - 1;
+			if (fu->cache != NULL && (type == OP_LD || type == OP_ST)) {
+				fu->remain[u] = cacheRemain(fu, u, inst);
+			}
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/*
+	Returns 1 if the dest register of the unit is held in the status arrays by a unit with an older instruction.
+*/
+int olderHolder(int *busy_type, int *busy_idx, Inst_queue *iq, Unit_table *fu, int u) {
+	int reg = fu->f_i[u], type = busy_type[reg], slot, v, age = queueAge(iq, fu->inst_idx[u]);
+	if (busy_idx[reg] == -1) {
+		return 0;
+	}
+	// The slots of a pipelined unit share its index
+	for (slot = 0; slot < fu->slots[type]; slot++) {
+		v = fu->first[type] + busy_idx[reg] + slot * fu->units[type];
+		if (v != u && fu->inst_idx[v] != -1 && fu->f_i[v] == reg && queueAge(iq, fu->inst_idx[v]) < age) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+	Marks the dest field of a store in the status arrays on its execution cycle, unless an older unit holds that register: the store doesn't
+	write it, so that unit would never get it back. A store held by an earlier load gives the register back instead, and it is added to the
+	released bitmask for clearBusyReg, since the load may be waiting for a unit that reads it (RAW) or for the register itself (WAW).
+	Returns 1 if the status arrays changed.
+*/
+int storeDst(int *busy_type, int *busy_idx, Inst_queue *iq, Unit_table *fu, int u, int held, int *released) {
+	int reg = fu->f_i[u];
+	int own = busy_type[reg] == OP_ST && busy_idx[reg] == fu->index[u];
+	if (held) {
+		if (!own) {
+			return 0;
+		}
+		busy_type[reg] = -1;
+		busy_idx[reg] = -1;
+		*released |= 1 << reg;
+		return 1;
+	}
+	if (own || olderHolder(busy_type, busy_idx, iq, fu, u)) {
+		return 0;
+	}
+	busy_type[reg] = OP_ST;
+	busy_idx[reg] = fu->index[u];
+	return 1;
+}
+
+/*
+	Returns 1 if any unit changed state this cycle beyond counting down its remain.
+	Units that only counted down are reported through next_event (-1 if there are none), and the dest fields given back by held stores
+	are added to the released bitmask (see storeDst).
+	Loads pass the earlier stores, and a store is held while an earlier load of its address is busy. With the memory dependence table
+	a load takes the data of an earlier store of its address that has it, and a store is only held until the earlier loads read the memory.
+*/
+int execComp(float *F, int *busy_type, int *busy_idx, Inst_queue *iq, int cc, Unit_table * fu, Sim_mem *mem, int legacy_float, int *next_event, int *stalls, int *released) {
+	int u = 0, j = 0, type, load_temp, read, changed = 0, prev_remain, cause, store = -1, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	int last_load = fu->first[OP_LD] + fu->count[OP_LD];
+	Inst *q = iq->q, *inst;
+	*next_event = -1;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			type = fu->type[u];
+			if ((needsJ(fu, type) && fu->r_j[u] != 1) || (fu_needs_k[type] && fu->r_k[u] != 1)) {
+				continue;
+			}
+			if (fu->remain[u] < (fu_eager[type] ? 0 : 1)) {
+				continue;
+			}
+			inst = &q[fu->inst_idx[u]];
+			read = inst->read;
+			if (fu_eager[type] ? (read > cc || read <= 0) : read >= cc) { // last cycle this fu completed read operation.
+				continue;
+			}
+			if (type == OP_LD && fu->deps != NULL && fu->result[u] == -1) {
+				// The load reads the memory now, or takes the data of an earlier store of its address from the store buffer
+				depsHazard(fu, iq, u, &store);
+			}
+			if (fu_claims_dst[type] && type != OP_ST) { // A store marks its dest field once it knows whether it is held, see storeDst
+				if (busy_type[fu->f_i[u]] != type || busy_idx[fu->f_i[u]] != fu->index[u]) {
+					changed = 1;
+				}
+				busy_type[fu->f_i[u]] = type;
+				busy_idx[fu->f_i[u]] = fu->index[u];
+			}
+			if (fu->result[u] == -1) {
+				switch (type) {
+				case OP_ADD:
+					fu->result[u] = F[fu->f_j[u]] + F[fu->f_k[u]];
+					break;
+				case OP_SUB:
+					fu->result[u] = F[fu->f_j[u]] - F[fu->f_k[u]];
+					break;
+				case OP_MULT:
+					fu->result[u] = F[fu->f_j[u]] * F[fu->f_k[u]];
+					break;
+				case OP_DIV:
+					fu->result[u] = F[fu->f_j[u]] / F[fu->f_k[u]];
+					break;
+				case OP_LD:
+					if (fu->deps != NULL && store != -1) { // Forwarded from the store buffer, done this cycle
+						fu->result[u] = fu->result[store];
+						fu->remain[u] = 1;
+						break;
+					}
+					load_temp = memRead(mem, inst->addr);
+					fu->result[u] = legacy_float ? single_pre_to_float_legacy(load_temp) : single_pre_to_float(load_temp);
+					break;
+				case OP_ST:
+					fu->result[u] = F[fu->f_k[u]];
+					break;
+				}
+				changed = 1;
+			}
+			prev_remain = fu->remain[u];
+			fu->remain[u]--;
+
+			if (type == OP_ST && fu->deps != NULL) {
+				// The store writes the memory once the earlier loads and stores of its address accessed it
+				if (fu->remain[u] == 0 && (cause = depsHazard(fu, iq, u, &store)) != -1) {
+					fu->remain[u]++;
+					stalls[cause]++;
+				}
+			}
+			else if (type == OP_ST) {
+				// To check if load inst colide with this store inst, if so, delay the store execution
+				for (j = fu->first[OP_LD]; j < last_load; j++) {
+					// Check if addresses values of store and load collide
+					if (fu->inst_idx[j] != -1) {
+						// With base addressing a load that didn't read its base register yet may be on the same address
+						if (q[fu->inst_idx[j]].addr == inst->addr || (fu->base_addressing && q[fu->inst_idx[j]].read == -1)) {
+							// Check that colided load inst is issued before store
+							if (q[fu->inst_idx[j]].issue < inst->issue) {
+								// Check if load instruction finished it execution
+								if (q[fu->inst_idx[j]].exec <= cc) {
+									// If load inst has not finished its execution delayed store 1 more cycle
+									if (fu->remain[u] == 0) {
+										fu->remain[u]++;
+										stalls[STALL_WAR]++;
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+			if (type == OP_ST) {
+				changed |= storeDst(busy_type, busy_idx, iq, fu, u, fu->remain[u] == prev_remain, released);
+			}
+			if (fu->remain[u] <= 0) {
+				if (type == OP_ST) {
+					memWrite(mem, inst->addr, legacy_float ? floatToSinglePre_legacy(fu->result[u]) : floatToSinglePre(fu->result[u]), 1);
+				}
+				inst->exec = cc;
+				changed = 1;
+			}
+			else if (fu->remain[u] != prev_remain) { // A delayed store keeps its remain and waits for the load to write back
+				noteCountdown(next_event, fu->remain[u]);
+			}
+		}
+	}
+	return changed;
+}
+
+/*
+	Registers released from the status arrays are added to the released bitmask, for clearBusyReg to notify their waiting units.
+*/
+int writeBack(float *F, int *busy_type, int *busy_idx, Inst *q, int cc, Unit_table * fu, int *released) {
+	int u = 0, type, changed = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	Inst *inst;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			type = fu->type[u];
+			if (fu->inst_idx[u] == -1) {
+				continue;
+			}
+			inst = &q[fu->inst_idx[u]];
+			if (fu_eager[type] ? (fu->remain[u] > 0 || inst->exec <= 0) : fu->remain[u] != 0) {
+				continue;
+			}
+			if (inst->exec < cc) { // last cycle this fu completed read operation.
+				if (fu_writes_reg[type]) {
+					F[fu->f_i[u]] = fu->result[u];
+				}
+				inst->write = cc;
+				fu->busy_cycles[u] += cc - inst->issue + 1;
+				if (busy_type[inst->dst] == type && busy_idx[inst->dst] == fu->index[u]) {
+					busy_type[inst->dst] = -1;
+					busy_idx[inst->dst] = -1;
+					*released |= 1 << inst->dst;
+				}
+				if (fu->deps != NULL) {
+					depsRemove(fu, u);
+				}
+				reset_unit(fu, u);
+				changed = 1;
+			}
+		}
+	}
+	return changed;
+}
+
+/*
+	Extra function to notify the units for next cycle which of the registers is free to read from, the status arrays are cleared by writeBack
+	(and execComp for a held store) into the released bitmask. Only the units that are registered as waiters of the released registers are visited, a unit is registered when it is issued with a busy source.
+	Returns 1 if any unit was notified.
+*/
+
+int clearBusyReg(Unit_table * fu, int released) {
+	int u = 0, reg, w, changed = 0, words = ((int)fu->used + 31) / 32;
+	unsigned int mask;
+	while (released) {
+		reg = lowestBit((unsigned int)released);
+		released &= released - 1;
+		for (w = 0; w < words; w++) {
+			mask = fu->waiters[w * REGS_NUM + reg];
+			fu->waiters[w * REGS_NUM + reg] = 0;
+			while (mask) {
+				u = w * 32 + lowestBit(mask);
+				mask &= mask - 1;
+				// A unit that finished meanwhile and was issued again may still be registered, it is only notified on its current sources
+				if (fu->f_j[u] == reg) {
+					changed |= fu->r_j[u] != 1 || fu->q_j_idx[u] != -1;
+					fu->r_j[u] = 1;
+					fu->q_j_idx[u] = -1;
+				}
+				if (fu->f_k[u] == reg) {
+					changed |= fu->r_k[u] != 1 || fu->q_k_idx[u] != -1;
+					fu->r_k[u] = 1;
+					fu->q_k_idx[u] = -1;
+				}
+			}
+		}
+	}
+	return changed;
+}
+
+/*
+	Fast forwards by the input number of cycles the units that are counting down their execution.
+	Called only after a quiet cycle, so every unit that has read its operands and has more than 1 remaining cycle is counting down.
+*/
+void skipUnitArr(Unit_table * fu, Inst *q, int cycles) {
+	int u = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			if (fu->inst_idx[u] != -1 && fu->remain[u] > 1 && q[fu->inst_idx[u]].read > 0) {
+				fu->remain[u] -= cycles;
+			}
+		}
+	}
+}
+
+/*
+	Tomasulo engine, selected by the tomasulo cfg key in place of the scoreboard steps above.
+	Each unit is a reservation station with its own execution unit. The status arrays rename the registers, they hold the unit
+	that produces the latest value of each register. So an instruction is issued even when its dest register is busy (no WAW stall),
+	and it captures its sources at issue, from the registers or later from the common data bus, where a later write can't change them (no WAR stall).
+	The instructions go through the same stages: read is the cycle all of its operands are captured and the execution starts,
+	exec the cycle it completes, and write the cycle its result goes out on the bus, to the waiting units and to the register
+	if no later instruction renamed it. The bus carries up to issue_width results a cycle, of the oldest instructions first.
+	LD/ST are kept in program order per address: a load waits for the earlier stores of its address to write the memory,
+	a store also for the earlier loads to read it. A load reads the memory and a store writes it when it completes.
+	With the memory dependence table (see Mem_deps) a load takes the data of the youngest earlier store of its address instead,
+	as soon as that store has it, and completes the cycle after it started.
+*/
+// Issues the instruction to a free unit of its type, capturing its ready sources and renaming its dest register.
+int tomIssueUnit(float *F, int *busy_type, int *busy_idx, Unit_table * fu, Inst *inst, int inst_idx) {
+	int u = findFreeUnit(fu, inst->opcode);
+	if (u == -1) {
+		return 0;
+	}
+	fu->active[u / 32] |= 1u << (u % 32);
+	inst->unit_index = fu->unit[u];
+	fu->busy[u] = 1;
+	fu->f_i[u] = inst->dst;
+	fu->f_j[u] = inst->src0;
+	fu->f_k[u] = inst->src1;
+	fu->q_j_type[u] = busy_type[inst->src0];
+	fu->q_j_idx[u] = busy_idx[inst->src0];
+	fu->q_k_type[u] = busy_type[inst->src1];
+	fu->q_k_idx[u] = busy_idx[inst->src1];
+	fu->r_j[u] = busy_type[inst->src0] == -1;
+	fu->r_k[u] = busy_type[inst->src1] == -1;
+	fu->v_j[u] = F[inst->src0];
+	fu->v_k[u] = F[inst->src1];
+	if (!fu->r_j[u]) {
+		fu->waiters[(u / 32) * REGS_NUM + inst->src0] |= 1u << (u % 32);
+	}
+	if (!fu->r_k[u]) {
+		fu->waiters[(u / 32) * REGS_NUM + inst->src1] |= 1u << (u % 32);
+	}
+	if (fu_writes_reg[inst->opcode]) {
+		busy_type[inst->dst] = inst->opcode;
+		busy_idx[inst->dst] = fu->index[u];
+	}
+	fu->inst_ptr[u] = inst;
+	fu->inst_idx[u] = inst_idx;
+	if (fu->deps != NULL && (inst->opcode == OP_LD || inst->opcode == OP_ST)) {
+		depsInsert(fu, u);
+	}
+	return 1;
+}
+
+/*
+	Issues the upcoming instructions of the queue in order, up to width instructions while there are free units of their types.
+	Returns the number of instructions issued this cycle. A structural stall is counted into stalls if none was issued.
+*/
+int tomIssue(float *F, int *busy_type, int *busy_idx, Inst_queue *iq, int cc, Unit_table * fu, int width, int *stalls) {
+	int issued = 0, slot;
+	Inst *inst;
+	while (issued < width && iq->next_issue != iq->tail) {
+		slot = iq->next_issue % iq->size;
+		inst = &iq->q[slot];
+		if (inst->opcode < OP_LD || inst->opcode > OP_DIV || !tomIssueUnit(F, busy_type, busy_idx, fu, inst, slot)) {
+			break;
+		}
+		inst->issue = cc;
+		iq->next_issue++;
+		issued++;
+	}
+	if (issued == 0 && iq->next_issue != iq->tail) {
+		stalls[STALL_STRUCT]++;
+	}
+	return issued;
+}
+
+/*
+	Checks if an earlier LD/ST of the same address (or of an address not known yet) holds the LD/ST unit from starting its execution.
+	Returns the stall cause, -1 if the unit may start.
+*/
+int tomMemHazard(Inst_queue *iq, Unit_table * fu, int u, unsigned int addr) {
+	int type = fu->type[u], age = queueAge(iq, fu->inst_idx[u]), t, j;
+	unsigned int other_addr;
+	Inst *other;
+	for (t = OP_LD; t <= OP_ST; t++) {
+		if (type == OP_LD && t == OP_LD) { // Loads don't hold each other
+			continue;
+		}
+		for (j = fu->first[t]; j < fu->first[t] + fu->count[t]; j++) {
+			if (fu->busy[j] != 1 || queueAge(iq, fu->inst_idx[j]) >= age) {
+				continue;
+			}
+			other = &iq->q[fu->inst_idx[j]];
+			if (other->exec == -1 && (!tomAddr(fu, j, other, &other_addr) || other_addr == addr)) {
+				return t == OP_LD ? STALL_WAR : (type == OP_LD ? STALL_RAW : STALL_WAW);
+			}
+		}
+	}
+	return -1;
+}
+
+/*
+	Starts the execution of the units that have all of their operands, the cycle after they were issued at the earliest.
+	Pipelined units are held and reported through next_start like in readOper.
+*/
+int tomRead(Inst_queue *iq, int cc, Unit_table * fu, int *next_start, int *stalls) {
+	int u = 0, type, cause, store, changed = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	Inst *inst;
+	*next_start = -1;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			type = fu->type[u];
+			inst = &iq->q[fu->inst_idx[u]];
+			if (cc <= inst->issue || inst->read != -1) {
+				continue;
+			}
+			if ((needsJ(fu, type) && fu->r_j[u] != 1) || (fu_needs_k[type] && fu->r_k[u] != 1)) {
+				stalls[STALL_RAW]++;
+				continue;
+			}
+			store = -1;
+			if (type == OP_LD || type == OP_ST) {
+				tomAddr(fu, u, inst, &inst->addr);
+				cause = fu->deps != NULL ? depsHazard(fu, iq, u, &store) : tomMemHazard(iq, fu, u, inst->addr);
+				if (cause != -1) {
+					stalls[cause]++;
+					continue;
+				}
+			}
+			if (!pipelineStart(fu, u, cc, next_start, stalls)) {
+				continue;
+			}
+			inst->read = cc;
+			fu->remain[u] = fu->delay[u] - 1;
+			if (store != -1) { // Forwarded from the store buffer, done the next cycle
+				fu->remain[u] = 0;
+			}
+			else if (fu->cache != NULL && (type == OP_LD || type == OP_ST)) {
+				fu->remain[u] = cacheRemain(fu, u, inst);
+			}
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/*
+	Counts down the executing units, a unit completes when its remain gets to 0. The latencies are the scoreboard's,
+	ADD already counts down in the cycle it started (fu_eager) and the rest from the next cycle.
+	Units that only counted down are reported through next_event, like execComp.
+*/
+int tomExec(Inst_queue *iq, int cc, Unit_table * fu, Sim_mem *mem, int legacy_float, int *next_event) {
+	int u = 0, type, store = -1, changed = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	Inst *inst;
+	*next_event = -1;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			type = fu->type[u];
+			inst = &iq->q[fu->inst_idx[u]];
+			if (inst->read == -1 || (fu_eager[type] ? inst->read > cc : inst->read >= cc) || inst->exec != -1) {
+				continue;
+			}
+			if (fu->remain[u] > 0) {
+				fu->remain[u]--;
+			}
+			if (fu->remain[u] > 0) {
+				noteCountdown(next_event, fu->remain[u]);
+				continue;
+			}
+			switch (type) {
+			case OP_ADD:
+				fu->result[u] = fu->v_j[u] + fu->v_k[u];
+				break;
+			case OP_SUB:
+				fu->result[u] = fu->v_j[u] - fu->v_k[u];
+				break;
+			case OP_MULT:
+				fu->result[u] = fu->v_j[u] * fu->v_k[u];
+				break;
+			case OP_DIV:
+				fu->result[u] = fu->v_j[u] / fu->v_k[u];
+				break;
+			case OP_LD:
+				if (fu->deps != NULL) { // The data of the store buffer, if an earlier store of the address didn't write the memory yet
+					depsHazard(fu, iq, u, &store);
+				}
+				if (store != -1) {
+					fu->result[u] = fu->v_k[store];
+					break;
+				}
+				fu->result[u] = legacy_float ? single_pre_to_float_legacy(memRead(mem, inst->addr)) : single_pre_to_float(memRead(mem, inst->addr));
+				break;
+			case OP_ST:
+				fu->result[u] = fu->v_k[u];
+				memWrite(mem, inst->addr, legacy_float ? floatToSinglePre_legacy(fu->result[u]) : floatToSinglePre(fu->result[u]), 1);
+				break;
+			}
+			inst->exec = cc;
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/*
+	Writes the result of the unit on the common data bus and frees the unit.
+	The waiting units of its dest register are visited, the ones waiting for this unit capture the result, the ones waiting
+	for another unit that renamed the register since stay registered.
+*/
+void tomBroadcast(float *F, int *busy_type, int *busy_idx, Inst_queue *iq, int cc, Unit_table * fu, int u) {
+	Inst *inst = &iq->q[fu->inst_idx[u]];
+	int type = fu->type[u], reg = fu->f_i[u], v, w, words = ((int)fu->used + 31) / 32;
+	unsigned int mask;
+
+	inst->write = cc;
+	fu->busy_cycles[u] += cc - inst->issue + 1;
+	if (busy_type[reg] == type && busy_idx[reg] == fu->index[u]) {
+		F[reg] = fu->result[u];
+		busy_type[reg] = -1;
+		busy_idx[reg] = -1;
+	}
+	for (w = 0; w < words; w++) {
+		mask = fu->waiters[w * REGS_NUM + reg];
+		while (mask) {
+			v = w * 32 + lowestBit(mask);
+			mask &= mask - 1;
+			if (fu->f_j[v] == reg && fu->r_j[v] != 1 && fu->q_j_type[v] == type && fu->q_j_idx[v] == fu->index[u]) {
+				fu->v_j[v] = fu->result[u];
+				fu->r_j[v] = 1;
+				fu->q_j_idx[v] = -1;
+			}
+			if (fu->f_k[v] == reg && fu->r_k[v] != 1 && fu->q_k_type[v] == type && fu->q_k_idx[v] == fu->index[u]) {
+				fu->v_k[v] = fu->result[u];
+				fu->r_k[v] = 1;
+				fu->q_k_idx[v] = -1;
+			}
+			if ((fu->f_j[v] != reg || fu->r_j[v] == 1) && (fu->f_k[v] != reg || fu->r_k[v] == 1)) {
+				fu->waiters[w * REGS_NUM + reg] &= ~(1u << (v % 32));
+			}
+		}
+	}
+	if (fu->deps != NULL) {
+		depsRemove(fu, u);
+	}
+	reset_unit(fu, u);
+}
+
+/*
+	Write back of the units that completed in an earlier cycle. Stores are done once they wrote the memory, the others take turns
+	on the common data bus, up to width of them by age. A completed unit left waiting for the bus is a structural stall.
+*/
+int tomWrite(float *F, int *busy_type, int *busy_idx, Inst_queue *iq, int cc, Unit_table * fu, int width, int *stalls) {
+	int u = 0, best, age, best_age, waiting = 0, n, changed = 0, w, words = ((int)fu->used + 31) / 32;
+	unsigned int active;
+	Inst *inst;
+	for (w = 0; w < words; w++) {
+		active = fu->active[w];
+		while (active) {
+			u = w * 32 + lowestBit(active);
+			active &= active - 1;
+			inst = &iq->q[fu->inst_idx[u]];
+			if (inst->exec == -1 || inst->exec >= cc) {
+				continue;
+			}
+			if (fu->type[u] == OP_ST) {
+				inst->write = cc;
+				fu->busy_cycles[u] += cc - inst->issue + 1;
+				if (fu->deps != NULL) {
+					depsRemove(fu, u);
+				}
+				reset_unit(fu, u);
+				changed = 1;
+			}
+			else {
+				waiting++;
+			}
+		}
+	}
+	for (n = 0; n < width && n < waiting; n++) {
+		best = -1;
+		best_age = 0;
+		for (w = 0; w < words; w++) {
+			active = fu->active[w];
+			while (active) {
+				u = w * 32 + lowestBit(active);
+				active &= active - 1;
+				inst = &iq->q[fu->inst_idx[u]];
+				if (inst->exec == -1 || inst->exec >= cc) {
+					continue;
+				}
+				age = queueAge(iq, fu->inst_idx[u]);
+				if (best == -1 || age < best_age) {
+					best = u;
+					best_age = age;
+				}
+			}
+		}
+		tomBroadcast(F, busy_type, busy_idx, iq, cc, fu, best);
+		changed = 1;
+	}
+	stalls[STALL_STRUCT] += waiting - n;
+	return changed;
+}
+
+#ifdef _WIN32
+DWORD WINAPI traceWriterThread(LPVOID arg) {
+#else
+void *traceWriterThread(void *arg) {
+#endif
+	Trace_writer *w = (Trace_writer*)arg;
+	char *buf;
+	size_t len;
+#ifdef _WIN32
+	EnterCriticalSection(&w->lock);
+#else
+	pthread_mutex_lock(&w->lock);
+#endif
+	while (1) {
+		while (w->flush_len == 0 && !w->closing) {
+#ifdef _WIN32
+			SleepConditionVariableCS(&w->cond, &w->lock, INFINITE);
+#else
+			pthread_cond_wait(&w->cond, &w->lock);
+#endif
+		}
+		if (w->flush_len == 0) { // Closing and nothing left to write
+			break;
+		}
+		buf = w->bufs[1 - w->fill_idx];
+		len = w->flush_len;
+#ifdef _WIN32
+		LeaveCriticalSection(&w->lock);
+		fwrite(buf, 1, len, w->file);
+		EnterCriticalSection(&w->lock);
+		w->flush_len = 0;
+		WakeAllConditionVariable(&w->cond);
+#else
+		pthread_mutex_unlock(&w->lock);
+		fwrite(buf, 1, len, w->file);
+		pthread_mutex_lock(&w->lock);
+		w->flush_len = 0;
+		pthread_cond_broadcast(&w->cond);
+#endif
+	}
+#ifdef _WIN32
+	LeaveCriticalSection(&w->lock);
+#else
+	pthread_mutex_unlock(&w->lock);
+#endif
+	return 0;
+}
+
+/*
+	Hands the filled buffer to the writer thread and switches to the other buffer.
+	Waits only if the writer thread is still writing the other buffer.
+*/
+void traceFlush(Trace_writer *w) {
+#ifdef _WIN32
+	EnterCriticalSection(&w->lock);
+	while (w->flush_len > 0) {
+		SleepConditionVariableCS(&w->cond, &w->lock, INFINITE);
+	}
+#else
+	pthread_mutex_lock(&w->lock);
+	while (w->flush_len > 0) {
+		pthread_cond_wait(&w->cond, &w->lock);
+	}
+#endif
+	w->flush_len = w->fill;
+	w->fill_idx = 1 - w->fill_idx;
+	w->fill = 0;
+	w->last_rec = -1;
+#ifdef _WIN32
+	WakeAllConditionVariable(&w->cond);
+	LeaveCriticalSection(&w->lock);
+#else
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+#endif
+}
+
+// Adds a record to the binary trace.
+void traceWrite(Trace_writer *w, const void *rec, size_t size) {
+	if (w->fill + size > TRACE_BUF_SIZE) {
+		traceFlush(w);
+	}
+	memcpy(w->bufs[w->fill_idx] + w->fill, rec, size);
+	w->fill += size;
+}
+
+/*
+	Opens a trace file, binary or text by the file name, magic is the binary trace magic.
+	Returns 0 if the file couldn't be opened.
+*/
+int openTrace(Trace_file *trace, char *path, const char *magic) {
+	Trace_writer *w;
+	size_t len = strlen(path);
+	trace->text = NULL;
+	trace->bin = NULL;
+	trace->recs = NULL;
+	if (len < 4 || strcmp(path + len - 4, ".bin") != 0) {
+		trace->text = fopen(path, "w");
+		return trace->text != NULL;
+	}
+	w = (Trace_writer*)calloc(1, sizeof(Trace_writer));
+	w->file = fopen(path, "wb");
+	if (w->file == NULL) {
+		free(w);
+		return 0;
+	}
+	w->bufs[0] = (char*)malloc(TRACE_BUF_SIZE);
+	w->bufs[1] = (char*)malloc(TRACE_BUF_SIZE);
+	w->last_rec = -1;
+#ifdef _WIN32
+	InitializeCriticalSection(&w->lock);
+	InitializeConditionVariable(&w->cond);
+	w->thread = CreateThread(NULL, 0, traceWriterThread, w, 0, NULL);
+#else
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->cond, NULL);
+	pthread_create(&w->thread, NULL, traceWriterThread, w);
+#endif
+	traceWrite(w, magic, 4);
+	trace->bin = w;
+	return 1;
+}
+
+// Writes what is left of the trace and closes it.
+void closeTrace(Trace_file *trace) {
+	Trace_writer *w = trace->bin;
+	if (trace->text != NULL) {
+		fclose(trace->text);
+	}
+	if (w != NULL) {
+		if (w->fill > 0) {
+			traceFlush(w);
+		}
+#ifdef _WIN32
+		EnterCriticalSection(&w->lock);
+		w->closing = 1;
+		WakeAllConditionVariable(&w->cond);
+		LeaveCriticalSection(&w->lock);
+		WaitForSingleObject(w->thread, INFINITE);
+		CloseHandle(w->thread);
+		DeleteCriticalSection(&w->lock);
+#else
+		pthread_mutex_lock(&w->lock);
+		w->closing = 1;
+		pthread_cond_broadcast(&w->cond);
+		pthread_mutex_unlock(&w->lock);
+		pthread_join(w->thread, NULL);
+		pthread_mutex_destroy(&w->lock);
+		pthread_cond_destroy(&w->cond);
+#endif
+		fclose(w->file);
+		free(w->bufs[0]);
+		free(w->bufs[1]);
+		free(w);
+	}
+	free(trace->recs);
+	trace->text = NULL;
+	trace->bin = NULL;
+	trace->recs = NULL;
+	trace->recs_num = 0;
+	trace->recs_size = 0;
+}
+
+/*
+	Formats the trace unit row of a record, without its leading clock cycle.
+*/
+void formatTraceUnit(char *row, Trace_unit_rec *rec) {
+	// String variables for printing purposes.
+	char q_j[6];
+	char q_k[6];
+
+	strcpy(q_j, "-");
+	strcpy(q_k, "-");
+	if (rec->q_j_idx != -1) {
+		sprintf(q_j, "%s%d", units_names[rec->q_j_type], rec->q_j_idx);
+	}
+	if (rec->q_k_idx != -1) {
+		sprintf(q_k, "%s%d", units_names[rec->q_k_type], rec->q_k_idx);
+	}
+	sprintf(row, " %s%d F%d F%d F%d %s %s %s %s\n", units_names[rec->type], rec->index, rec->f_i, rec->f_j, rec->f_k, q_j, q_k, yes_no[rec->r_j], yes_no[rec->r_k]);
+}
+
+// Formats the trace instruction line of a record.
+void formatTraceInst(char *line, Trace_inst_rec *rec) {
+	sprintf(line, "%.8X %d %s%d %d %d %d %d\n", rec->inst, rec->issue - 1, units_names[rec->opcode], rec->unit_index, rec->issue, rec->read, rec->exec, rec->write);
+}
+
+// Fills the trace record of the input unit, at cycle cc.
+void unitTraceRec(Trace_unit_rec *rec, Unit_table *fu, int u, int cc, int cycles) {
+	rec->cc = cc;
+	rec->cycles = cycles;
+	rec->type = fu->type[u];
+	rec->index = fu->unit[u];
+	rec->f_i = fu->f_i[u];
+	rec->f_j = fu->f_j[u];
+	rec->f_k = fu->f_k[u];
+	// The units are named by their physical unit, the slots of a pipelined unit share its name
+	rec->q_j_type = fu->q_j_type[u];
+	rec->q_j_idx = fu->q_j_idx[u] == -1 ? -1 : fu->unit[fu->first[fu->q_j_type[u]] + fu->q_j_idx[u]];
+	rec->q_k_type = fu->q_k_type[u];
+	rec->q_k_idx = fu->q_k_idx[u] == -1 ? -1 : fu->unit[fu->first[fu->q_k_type[u]] + fu->q_k_idx[u]];
+	rec->r_j = fu->r_j[u];
+	rec->r_k = fu->r_k[u];
+	if (fu->inst_ptr[u]->exec > 0) {
+		rec->r_j = 0;
+		rec->r_k = 0;
+	}
+}
+
+/*
+	Traces the busy units of the trace set for the cycles from cc on, their state is the same through all of them.
+	Rows are ordered by cycle, then by unit id. Cycles out of the trace window are left out.
+*/
+void traceUnits(Trace_file *trace, Unit_table *fu, Trace_set *set, int cc, int cycles) {
+	Trace_unit_rec rec;
+	Trace_unit_rec *last;
+	char row[TRACE_ROW_LENGTH];
+	char *rows = NULL;
+	int u, w, i, n = 0, words = ((int)fu->used + 31) / 32;
+	unsigned int units;
+
+	if (cc < set->from) {
+		cycles -= set->from - cc;
+		cc = set->from;
+	}
+	if (cycles > set->to - cc + 1) {
+		cycles = set->to - cc + 1;
+	}
+	if (cycles <= 0) {
+		return;
+	}
+	// Text rows of several cycles are formatted once, and printed for every cycle after all of the units
+	if (trace->text != NULL && cycles > 1) {
+		rows = (char*)malloc(fu->used * TRACE_ROW_LENGTH);
+	}
+	for (w = 0; w < words; w++) {
+		units = set->units[w] & fu->active[w];
+		while (units) {
+			u = w * 32 + lowestBit(units);
+			units &= units - 1;
+			unitTraceRec(&rec, fu, u, cc, cycles);
+			if (trace->bin != NULL) {
+				// The same row of the same unit right after the last one only extends it
+				if (trace->bin->last_rec != -1) {
+					last = (Trace_unit_rec*)(trace->bin->bufs[trace->bin->fill_idx] + trace->bin->last_rec);
+					if (last->cc + last->cycles == cc && memcmp(&last->index, &rec.index, sizeof(rec) - offsetof(Trace_unit_rec, index)) == 0) {
+						last->cycles += cycles;
+						continue;
+					}
+				}
+				traceWrite(trace->bin, &rec, sizeof(rec));
+				trace->bin->last_rec = (long)(trace->bin->fill - sizeof(rec));
+			}
+			else if (rows != NULL) {
+				formatTraceUnit(rows + n * TRACE_ROW_LENGTH, &rec);
+				n++;
+			}
+			else {
+				formatTraceUnit(row, &rec);
+				fprintf(trace->text, "%d%s", cc, row);
+			}
+		}
+	}
+	if (rows != NULL) {
+		for (i = 0; i < cycles * n; i++) {
+			fprintf(trace->text, "%d%s", cc + i / n, rows + (i % n) * TRACE_ROW_LENGTH);
+		}
+		free(rows);
+	}
+}
+// Traces the input instruction, once it was written back.
+void traceInst(Trace_file *trace, Inst *inst) {
+	Trace_inst_rec rec;
+	char line[BUF_SIZE];
+
+	rec.inst = inst->inst;
+	rec.opcode = inst->opcode;
+	rec.unit_index = inst->unit_index;
+	rec.issue = inst->issue;
+	rec.read = inst->read;
+	rec.exec = inst->exec;
+	rec.write = inst->write;
+	if (trace->bin != NULL) {
+		traceWrite(trace->bin, &rec, sizeof(rec));
+		return;
+	}
+	if (trace->text == NULL) {
+		if (trace->recs_num == trace->recs_size) {
+			trace->recs_size = trace->recs_size == 0 ? 64 : 2 * trace->recs_size;
+			trace->recs = (Trace_inst_rec*)realloc(trace->recs, trace->recs_size * sizeof(Trace_inst_rec));
+		}
+		trace->recs[trace->recs_num++] = rec;
+		return;
+	}
+	formatTraceInst(line, &rec);
+	fputs(line, trace->text);
+}
+
+/*
+	Prints to the trace instruction file the oldest instructions of the queue once they were written back, and retires them from the queue.
+	Instructions are issued in order, so the queue is in issue order and its head is always the next to print.
+	Up to width instructions are retired in a clock cycle.
+	Returns 0 if halt was reached and all of the issued instructions were printed already, meaning the simulation is over.
+*/
+int retireInst(Trace_file *trace_inst, Inst_queue *iq, int halt_reached, int width) {
+	Inst *head;
+	if (halt_reached && iq->head == iq->next_issue) {
+		return 0;
+	}
+	for (; width > 0 && iq->head != iq->next_issue; width--) {
+		head = &iq->q[iq->head % iq->size];
+		if (head->write <= 0) {
+			break;
+		}
+		if (trace_inst != NULL) {
+			traceInst(trace_inst, head);
+		}
+		iq->head++;
+	}
+	return 1;
+}
+
+/*
+	A memory image file name ending with ".bin" is a binary image: the raw 32 bit little endian words of the memory, from address 0,
+	with no header, so the file is mapped straight as the memory pages (see mapMemin). The rest of the memory is zero.
+	Any other file is the hex text format, a word per line, and every line is a word even if it's blank or not hex (then the word is 0).
+	A line starting with @ is an address and a word, like the sparse memout ("@00000100 3F800000"), then the next lines continue from that address.
+*/
+int isBinaryImage(char *path) {
+	size_t len = strlen(path);
+	return len >= 4 && strcmp(path + len - 4, ".bin") == 0;
+}
+
+/*
+	Maps a binary memin image copy-on-write (MAP_PRIVATE, FILE_MAP_COPY on Windows) as the initial words of the memory pages,
+	so the file isn't read up front, a page is only read from the file once it is accessed and only copied once it is stored to,
+	and the file itself never changes. The pages past the end of the file stay unallocated.
+	The file is mapped in whole pages, the words of the last page past the end of the file read as 0 like the rest of the mapping.
+	Returns 0 if the file couldn't be mapped.
+*/
+int mapMemin(char *memin_path, Sim_mem *mem) {
+	unsigned long long size, pages, max_pages = ((unsigned long long)mem->addr_mask + 1) / PAGE_WORDS, p;
+	Mem_page *page;
+	char *image;
+#ifdef _WIN32
+	HANDLE file, map;
+	LARGE_INTEGER file_size;
+
+	file = CreateFileA(memin_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return 0;
+	}
+	size = (unsigned long long)file_size.QuadPart;
+	pages = (size + PAGE_WORDS * sizeof(int) - 1) / (PAGE_WORDS * sizeof(int));
+	map = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	image = map == NULL ? NULL : (char*)MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0);
+	if (map != NULL) {
+		CloseHandle(map);
+	}
+	CloseHandle(file);
+	if (image == NULL) {
+		return 0;
+	}
+#else
+	struct stat st;
+	int fd = open(memin_path, O_RDONLY);
+
+	if (fd == -1) {
+		return 0;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return 0;
+	}
+	size = (unsigned long long)st.st_size;
+	pages = (size + PAGE_WORDS * sizeof(int) - 1) / (PAGE_WORDS * sizeof(int));
+	image = (char*)mmap(NULL, pages * PAGE_WORDS * sizeof(int), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == (char*)MAP_FAILED) {
+		return 0;
+	}
+#endif
+	mem->image = image;
+	mem->image_len = (size_t)(pages * PAGE_WORDS * sizeof(int));
+	if (pages > max_pages) {
+		pages = max_pages;
+	}
+	for (p = 0; p < pages; p++) {
+		if (mem->tables[p >> TABLE_BITS] == NULL) {
+			mem->tables[p >> TABLE_BITS] = (Mem_page**)calloc(TABLE_PAGES, sizeof(Mem_page*));
+		}
+		page = (Mem_page*)calloc(1, sizeof(Mem_page));
+		page->words = (int*)(image + p * PAGE_WORDS * sizeof(int));
+		mem->tables[p >> TABLE_BITS][p & (TABLE_PAGES - 1)] = page;
+	}
+	return 1;
+}
+
+/*
+	Reads the memin file into the memory. A binary image is mapped (see mapMemin), or read if it can't be,
+	then only pages with non zero words are allocated.
+	Returns 0 if the file couldn't be opened.
+*/
+int readMemin(char *memin_path, Sim_mem *mem) {
+	FILE* memin;
+	char line[MAX_LINE_LENGTH];
+	int chunk[PAGE_WORDS];
+	char *pos;
+	unsigned int addr = 0, at, word, i;
+	int parsed;
+	size_t words;
+
+	if (isBinaryImage(memin_path) && mapMemin(memin_path, mem)) {
+		return 1;
+	}
+	if (isBinaryImage(memin_path)) {
+		memin = fopen(memin_path, "rb");
+		if (memin == NULL) {
+			printf("couldn't open the memin file");
+			return 0;
+		}
+		// A page at a time, all zero pages are left unallocated
+		while ((words = fread(chunk, sizeof(int), PAGE_WORDS, memin)) > 0) {
+			for (i = 0; i < words && chunk[i] == 0; i++);
+			if (i < words) {
+				memcpy(memAllocPage(mem, addr)->words, chunk, words * sizeof(int));
+			}
+			addr += PAGE_WORDS;
+			if (addr > mem->addr_mask || addr == 0) {
+				break;
+			}
+		}
+		fclose(memin);
+		return 1;
+	}
+
+	memin = fopen(memin_path, "r");
+	if (memin == NULL) {
+		printf("couldn't open the memin file");
+		return 0;
+	}
+	while (fgets(line, MAX_LINE_LENGTH, memin) != NULL) {
+		for (pos = line; *pos == ' ' || *pos == '\t'; pos++);
+		if (*pos == '@') {
+			parsed = sscanf(pos + 1, "%x %x", &at, &word) == 2;
+			if (parsed) {
+				addr = at & mem->addr_mask;
+			}
+		}
+		else {
+			parsed = sscanf(pos, "%x", &word) == 1;
+		}
+		if (parsed) {
+			memWrite(mem, addr, word, 0);
+		}
+		addr = (addr + 1) & mem->addr_mask;
+		if (addr == 0) {
+			break;
+		}
+	}
+	fclose(memin);
+	return 1;
+}
+
+// Writes the input word as 8 upper case hex digits, same as "%.8X".
+void formatHexWord(char *buf, unsigned int word) {
+	static const char hex[] = "0123456789ABCDEF";
+	int i;
+	for (i = 7; i >= 0; i--) {
+		buf[i] = hex[word & 0xF];
+		word >>= 4;
+	}
+}
+
+/*
+	Writes the memory to the memout file, as a binary image or as hex text by the file name (see isBinaryImage).
+	A full memout is written up to the last allocated page, and at least MEM_LENGTH_SIM words.
+	A sparse text memout only has the words written by stores, a line per word with @, its address and value, both 8 hex digits,
+	so it can be read back as a memin (see isBinaryImage).
+	The text is formatted a page at a time into a buffer, which is written at once.
+	Returns 0 if the file couldn't be opened.
+*/
+int writeMemout(char *memout_path, Sim_mem *mem, int sparse) {
+	static const int zero_page[PAGE_WORDS] = { 0 };
+	FILE* memout;
+	Mem_page *page;
+	const int *words;
+	char *buf, *pos;
+	unsigned int pages, p, i, addr;
+	int binary = isBinaryImage(memout_path);
+
+	memout = fopen(memout_path, binary ? "wb" : "w");
+	if (memout == NULL) {
+		printf("couldn't open the memout file");
+		return 0;
+	}
+	// Longest line is the sparse one, @, 2 words, a space and a new line.
+	buf = (char*)malloc(PAGE_WORDS * 19);
+	pages = memDumpPages(mem);
+	for (p = 0; p < pages; p++) {
+		addr = p * PAGE_WORDS;
+		page = memPage(mem, addr);
+		if (sparse && !binary) {
+			if (page == NULL) {
+				continue;
+			}
+			pos = buf;
+			for (i = 0; i < PAGE_WORDS; i++) {
+				if (page->dirty[i / 32] & (1u << (i % 32))) {
+					pos[0] = '@';
+					formatHexWord(pos + 1, addr + i);
+					pos[9] = ' ';
+					formatHexWord(pos + 10, page->words[i]);
+					pos[18] = '\n';
+					pos += 19;
+				}
+			}
+			fwrite(buf, 1, pos - buf, memout);
+			continue;
+		}
+		words = page == NULL ? zero_page : page->words;
+		if (binary) {
+			fwrite(words, sizeof(int), PAGE_WORDS, memout);
+			continue;
+		}
+		for (i = 0; i < PAGE_WORDS; i++) {
+			formatHexWord(buf + i * 9, words[i]);
+			buf[i * 9 + 8] = '\n';
+		}
+		fwrite(buf, 1, PAGE_WORDS * 9, memout);
+	}
+	free(buf);
+	fclose(memout);
+	return 1;
+}
+
+/*
+	Converts a memory image between the hex text format and the binary format, by the file names.
+	Returns 1 on success.
+*/
+int convertMemImage(char *in_path, char *out_path) {
+	Sim_mem mem;
+	int res;
+	init_mem(&mem, 32);
+	res = readMemin(in_path, &mem) && writeMemout(out_path, &mem, 0);
+	free_mem(&mem);
+	return res;
+}
+
+/*
+	Empties the instructions queue and the registers status and starts the clock over, the registers and the memory are kept.
+	The units are all free by then, when the simulation ran to its end.
+*/
+void resetPipeline(Sim_ctx *ctx) {
+	int i;
+	// Inits instructions queue
+	for (i = 0; i < ctx->iq.size; i++) {
+		ctx->iq.q[i] = init_inst();
+	}
+	ctx->iq.head = 0;
+	ctx->iq.next_issue = 0;
+	ctx->iq.tail = 0;
+
+	for (i = 0; i < REGS_NUM; i++) {
+		ctx->busy_idx[i] = -1;
+		ctx->busy_type[i] = -1;
+	}
+	ctx->cc = 1;
+	ctx->halt_reached = 0;
+}
+
+/*
+	Initializes the state of a simulation context with a queue of queue_depth instructions,
+	the function units and the memory are set by the caller.
+*/
+void initSimCtx(Sim_ctx *ctx, int queue_depth) {
+	int i;
+	ctx->iq.size = queue_depth;
+	ctx->iq.q = (Inst*)malloc(queue_depth * sizeof(Inst));
+	resetPipeline(ctx);
+
+	// Inits registers
+	for (i = 0; i < REGS_NUM; i++) {
+		ctx->F[i] = 1.0 * i;
+	}
+	ctx->inst_num = 0;
+	ctx->fetch_width = 1;
+	ctx->issue_width = 1;
+	memset(&ctx->stats, 0, sizeof(Sim_stats));
+	ctx->stats.queue_hist = (long long*)calloc(queue_depth + 1, sizeof(long long));
+}
+
+// Frees the function units, the queue and the stats of a context. The memory is freed by the caller, after it was written out.
+void freeSimCtx(Sim_ctx *ctx) {
+	free_unit_table(&ctx->fu);
+	free(ctx->iq.q);
+	free(ctx->stats.queue_hist);
+	ctx->iq.q = NULL;
+	ctx->stats.queue_hist = NULL;
+}
+
+// Sets the options of the library config in an initialized context.
+void configureSimCtx(Sim_ctx *ctx, const Sim_config *cfg) {
+	ctx->fu.base_addressing = cfg->base_addressing;
+	ctx->legacy_float = cfg->legacy_float;
+	ctx->fetch_width = cfg->fetch_width;
+	ctx->issue_width = cfg->issue_width;
+	ctx->tomasulo = cfg->tomasulo;
+	if (cfg->mem_disambiguation) {
+		initMemDeps(&ctx->fu, cfg->tomasulo);
+	}
+	if (cfg->cache_size > 0) {
+		initDataCache(&ctx->fu, cfg);
+	}
+}
+
+/*
+	Checkpoints, all of the simulation state at the start of a clock cycle, so a run can resume from that cycle.
+	A checkpoint file is a 4 bytes magic "SBCK", a Checkpoint_header, the queued instructions from head to tail,
+	a Checkpoint_unit for each busy unit, the allocated memory pages, each a page number followed by its words and dirty mask,
+	and the tags, flags and stamps arrays of the data cache lines, all in the native layout.
+	A unit is saved by its type and index instead of its id, and its instruction by its offset from the queue head instead of inst_ptr,
+	so a checkpoint can be restored into the units and queue of another cfg as long as the busy units exist and the instructions fit in it.
+*/
+typedef struct {
+	int cc;
+	int inst_num;
+	int halt_reached;
+	float F[REGS_NUM];
+	int busy_type[REGS_NUM];
+	int busy_idx[REGS_NUM];
+	// Queue positions, see Inst_queue
+	int head;
+	int next_issue;
+	int tail;
+	// The engine that saved it, the units state of the scoreboard and of the Tomasulo engine don't mix
+	int tomasulo;
+	// Physical units of each type, the slots of pipelined units are indexed by them (see Unit_table)
+	int units[6];
+	unsigned int addr_mask;
+	int units_num;
+	unsigned int pages_num;
+	// Geometry of the data cache, 0 sets if there is none, and the state of its replacement
+	int cache_sets;
+	int cache_ways;
+	int cache_line;
+	unsigned int cache_seed;
+	unsigned long long cache_accesses;
+} Checkpoint_header;
+
+// Size of a saved memory page, its words and its dirty mask
+#define CHECKPOINT_PAGE_SIZE (PAGE_WORDS * sizeof(int) + PAGE_WORDS / 32 * sizeof(unsigned int))
+
+typedef struct {
+	int type;
+	// Physical unit and slot
+	int index;
+	int slot;
+	int f_i;
+	int f_j;
+	int f_k;
+	int q_j_type;
+	int q_j_idx;
+	int q_k_type;
+	int q_k_idx;
+	int r_j;
+	int r_k;
+	int remain;
+	int inst_idx;
+	int waw_flag;
+	float result;
+	float v_j;
+	float v_k;
+	// Pipeline state of the physical unit, see pipelineStart
+	int next_read;
+} Checkpoint_unit;
+
+/*
+	Saves the state of the context to the checkpoint file, called at the start of a clock cycle.
+	Returns 0 if the file couldn't be written.
+*/
+int saveCheckpoint(char *path, Sim_ctx *ctx) {
+	FILE *file;
+	Checkpoint_header hdr;
+	Checkpoint_unit unit;
+	Unit_table *fu = &ctx->fu;
+	unsigned int t, p, page_num;
+	int u, i, lines;
+
+	file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("couldn't open the checkpoint file");
+		return 0;
+	}
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.cc = ctx->cc;
+	hdr.inst_num = ctx->inst_num;
+	hdr.halt_reached = ctx->halt_reached;
+	memcpy(hdr.F, ctx->F, sizeof(hdr.F));
+	memcpy(hdr.busy_type, ctx->busy_type, sizeof(hdr.busy_type));
+	memcpy(hdr.busy_idx, ctx->busy_idx, sizeof(hdr.busy_idx));
+	hdr.head = ctx->iq.head;
+	hdr.next_issue = ctx->iq.next_issue;
+	hdr.tail = ctx->iq.tail;
+	hdr.tomasulo = ctx->tomasulo;
+	memcpy(hdr.units, fu->units, sizeof(hdr.units));
+	hdr.addr_mask = ctx->mem.addr_mask;
+	if (fu->cache != NULL) {
+		hdr.cache_sets = fu->cache->sets;
+		hdr.cache_ways = fu->cache->ways;
+		hdr.cache_line = fu->cache->line;
+		hdr.cache_seed = fu->cache->seed;
+		hdr.cache_accesses = fu->cache->accesses;
+	}
+	for (u = 0; u < (int)fu->used; u++) {
+		hdr.units_num += fu->busy[u] == 1;
+	}
+	for (t = 0; t < ctx->mem.tables_num; t++) {
+		for (p = 0; ctx->mem.tables[t] != NULL && p < TABLE_PAGES; p++) {
+			hdr.pages_num += ctx->mem.tables[t][p] != NULL;
+		}
+	}
+	fwrite("SBCK", 1, 4, file);
+	fwrite(&hdr, sizeof(hdr), 1, file);
+	for (i = hdr.head; i < hdr.tail; i++) {
+		fwrite(&ctx->iq.q[i % ctx->iq.size], sizeof(Inst), 1, file);
+	}
+
+	for (u = 0; u < (int)fu->used; u++) {
+		if (fu->busy[u] != 1) { // A free unit is in its reset state
+			continue;
+		}
+		memset(&unit, 0, sizeof(unit));
+		unit.type = fu->type[u];
+		unit.index = fu->unit[u];
+		unit.slot = fu->index[u] / fu->units[unit.type];
+		unit.f_i = fu->f_i[u];
+		unit.f_j = fu->f_j[u];
+		unit.f_k = fu->f_k[u];
+		unit.q_j_type = fu->q_j_type[u];
+		unit.q_j_idx = fu->q_j_idx[u];
+		unit.q_k_type = fu->q_k_type[u];
+		unit.q_k_idx = fu->q_k_idx[u];
+		unit.r_j = fu->r_j[u];
+		unit.r_k = fu->r_k[u];
+		unit.remain = fu->remain[u];
+		unit.inst_idx = (fu->inst_idx[u] - hdr.head % ctx->iq.size + ctx->iq.size) % ctx->iq.size;
+		unit.waw_flag = fu->waw_flag[u];
+		unit.result = fu->result[u];
+		unit.v_j = fu->v_j[u];
+		unit.v_k = fu->v_k[u];
+		unit.next_read = fu->next_read[unitLead(fu, u)];
+		fwrite(&unit, sizeof(unit), 1, file);
+	}
+
+	for (t = 0; t < ctx->mem.tables_num; t++) {
+		for (p = 0; ctx->mem.tables[t] != NULL && p < TABLE_PAGES; p++) {
+			if (ctx->mem.tables[t][p] != NULL) {
+				page_num = (t << TABLE_BITS) + p;
+				fwrite(&page_num, sizeof(page_num), 1, file);
+				fwrite(ctx->mem.tables[t][p]->words, sizeof(int), PAGE_WORDS, file);
+				fwrite(ctx->mem.tables[t][p]->dirty, sizeof(ctx->mem.tables[t][p]->dirty), 1, file);
+			}
+		}
+	}
+	if (fu->cache != NULL) {
+		lines = fu->cache->sets * fu->cache->ways;
+		fwrite(fu->cache->tags, sizeof(unsigned int), lines, file);
+		fwrite(fu->cache->flags, sizeof(unsigned char), lines, file);
+		fwrite(fu->cache->stamps, sizeof(unsigned long long), lines, file);
+	}
+	if (ferror(file)) {
+		printf("couldn't write the checkpoint file");
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+	return 1;
+}
+
+/*
+	Reads a whole checkpoint file into a buffer, so it can be restored any number of times.
+	Returns NULL if the file couldn't be read or is not a valid checkpoint. The buffer is freed by the caller.
+*/
+char *readCheckpoint(char *path, size_t *len) {
+	FILE *file;
+	char *buf;
+	long size;
+	Checkpoint_header hdr;
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("couldn't open the checkpoint file");
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size < 4 + (long)sizeof(hdr)) {
+		printf("invalid checkpoint file\n");
+		fclose(file);
+		return NULL;
+	}
+	buf = (char*)malloc(size);
+	*len = fread(buf, 1, size, file);
+	fclose(file);
+
+	memcpy(&hdr, buf + 4, sizeof(hdr));
+	if (memcmp(buf, "SBCK", 4) != 0 || hdr.units_num < 0 || hdr.head > hdr.next_issue || hdr.next_issue > hdr.tail ||
+		hdr.tail - hdr.head > QUEUE_DEPTH_MAX ||
+		*len != 4 + sizeof(hdr) + (hdr.tail - hdr.head) * sizeof(Inst) + hdr.units_num * sizeof(Checkpoint_unit) +
+		hdr.pages_num * (sizeof(unsigned int) + CHECKPOINT_PAGE_SIZE) +
+		(size_t)hdr.cache_sets * hdr.cache_ways * (sizeof(unsigned int) + sizeof(unsigned char) + sizeof(unsigned long long))) {
+		printf("invalid checkpoint file\n");
+		free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+// Index in the table of a unit index of the checkpoint, whose slots are laid out by the units numbers of the checkpoint.
+int checkpointIndex(Checkpoint_header *hdr, Unit_table *fu, int type, int index) {
+	if (index == -1 || hdr->units[type] == 0) {
+		return index;
+	}
+	return index % hdr->units[type] + index / hdr->units[type] * fu->units[type];
+}
+
+/*
+	Restores a checkpoint read by readCheckpoint into the context. The units of the context are already inserted (by the cfg)
+	and its memory is not initialized yet. The busy units of the checkpoint go to the units of the same type and index,
+	a unit that didn't read its operands yet will count down the delay of the new cfg. The slots of a pipelined unit go to the same slots.
+	The waiting registers of the units are rebuilt from their r_j/r_k, and so is the memory dependence table, and inst_ptr points into the restored queue.
+	Returns 0 if a busy unit of the checkpoint doesn't exist in the table, its instructions don't fit in the queue
+	or it was saved by the other engine.
+*/
+int restoreCheckpoint(Sim_ctx *ctx, const char *buf) {
+	Checkpoint_header hdr;
+	Checkpoint_unit unit;
+	Unit_table *fu = &ctx->fu;
+	Data_cache *cache;
+	Mem_page *page;
+	const char *pos = buf + 4;
+	unsigned int p, page_num, bits;
+	int i, u, lines;
+
+	memcpy(&hdr, pos, sizeof(hdr));
+	pos += sizeof(hdr);
+	ctx->cc = hdr.cc;
+	ctx->inst_num = hdr.inst_num;
+	ctx->halt_reached = hdr.halt_reached;
+	memcpy(ctx->F, hdr.F, sizeof(hdr.F));
+	memcpy(ctx->busy_type, hdr.busy_type, sizeof(hdr.busy_type));
+	for (i = 0; i < REGS_NUM; i++) {
+		ctx->busy_idx[i] = checkpointIndex(&hdr, fu, hdr.busy_type[i], hdr.busy_idx[i]);
+	}
+	if (hdr.tomasulo != ctx->tomasulo) {
+		printf("the checkpoint was saved by the %s engine\n", hdr.tomasulo ? "tomasulo" : "scoreboard");
+		return 0;
+	}
+	if (hdr.tail - hdr.head > ctx->iq.size) {
+		printf("the checkpoint has %d queued instructions, more than the queue_depth of the cfg\n", hdr.tail - hdr.head);
+		return 0;
+	}
+	ctx->iq.head = hdr.head;
+	ctx->iq.next_issue = hdr.next_issue;
+	ctx->iq.tail = hdr.tail;
+	for (i = hdr.head; i < hdr.tail; i++) {
+		memcpy(&ctx->iq.q[i % ctx->iq.size], pos, sizeof(Inst));
+		pos += sizeof(Inst);
+	}
+
+	for (i = 0; i < hdr.units_num; i++) {
+		memcpy(&unit, pos, sizeof(unit));
+		pos += sizeof(unit);
+		if (unit.type < 0 || unit.type > 5 || unit.index < 0 || unit.index >= fu->units[unit.type] ||
+			unit.inst_idx < 0 || unit.inst_idx >= hdr.tail - hdr.head) {
+			printf("the checkpoint unit %s%d doesn't exist in the cfg\n", unit.type >= 0 && unit.type <= 5 ? units_names[unit.type] : "?", unit.index);
+			return 0;
+		}
+		if (unit.slot < 0 || unit.slot >= fu->slots[unit.type]) {
+			printf("the checkpoint unit %s%d doesn't have its pipeline slots in the cfg\n", units_names[unit.type], unit.index);
+			return 0;
+		}
+		u = fu->first[unit.type] + unit.index + unit.slot * fu->units[unit.type];
+		fu->busy[u] = 1;
+		fu->f_i[u] = unit.f_i;
+		fu->f_j[u] = unit.f_j;
+		fu->f_k[u] = unit.f_k;
+		fu->q_j_type[u] = unit.q_j_type;
+		fu->q_j_idx[u] = checkpointIndex(&hdr, fu, unit.q_j_type, unit.q_j_idx);
+		fu->q_k_type[u] = unit.q_k_type;
+		fu->q_k_idx[u] = checkpointIndex(&hdr, fu, unit.q_k_type, unit.q_k_idx);
+		fu->r_j[u] = unit.r_j;
+		fu->r_k[u] = unit.r_k;
+		fu->remain[u] = unit.remain;
+		fu->next_read[unitLead(fu, u)] = unit.next_read;
+		fu->inst_idx[u] = (hdr.head + unit.inst_idx) % ctx->iq.size;
+		fu->inst_ptr[u] = &ctx->iq.q[fu->inst_idx[u]];
+		fu->waw_flag[u] = unit.waw_flag;
+		fu->result[u] = unit.result;
+		fu->v_j[u] = unit.v_j;
+		fu->v_k[u] = unit.v_k;
+		fu->active[u / 32] |= 1u << (u % 32);
+		if (unit.r_j == 0) {
+			fu->waiters[(u / 32) * REGS_NUM + unit.f_j] |= 1u << (u % 32);
+		}
+		if (unit.r_k == 0) {
+			fu->waiters[(u / 32) * REGS_NUM + unit.f_k] |= 1u << (u % 32);
+		}
+		if (fu->deps != NULL && (unit.type == OP_LD || unit.type == OP_ST)) {
+			depsInsert(fu, u);
+		}
+	}
+
+	for (bits = 0; bits < 32 && (hdr.addr_mask >> bits) & 1; bits++);
+	init_mem(&ctx->mem, bits);
+	for (p = 0; p < hdr.pages_num; p++) {
+		memcpy(&page_num, pos, sizeof(page_num));
+		pos += sizeof(page_num);
+		page = memAllocPage(&ctx->mem, page_num * PAGE_WORDS);
+		memcpy(page->words, pos, PAGE_WORDS * sizeof(int));
+		memcpy(page->dirty, pos + PAGE_WORDS * sizeof(int), sizeof(page->dirty));
+		pos += CHECKPOINT_PAGE_SIZE;
+	}
+
+	// The cache lines are restored into a cache of the same geometry, another cache starts empty
+	cache = fu->cache;
+	if (cache != NULL && cache->sets == hdr.cache_sets && cache->ways == hdr.cache_ways && cache->line == hdr.cache_line) {
+		lines = cache->sets * cache->ways;
+		memcpy(cache->tags, pos, lines * sizeof(unsigned int));
+		pos += lines * sizeof(unsigned int);
+		memcpy(cache->flags, pos, lines * sizeof(unsigned char));
+		pos += lines * sizeof(unsigned char);
+		memcpy(cache->stamps, pos, lines * sizeof(unsigned long long));
+		cache->seed = hdr.cache_seed;
+		cache->accesses = hdr.cache_accesses;
+	}
+	return 1;
+}
+
+// Saves the checkpoint of the context if it is due at the start of the current cycle, only once.
+void checkpointCycle(Sim_ctx *ctx) {
+	if (ctx->checkpoint_at == ctx->cc || (ctx->checkpoint_at == -1 && ctx->halt_reached)) {
+		saveCheckpoint(ctx->checkpoint_path, ctx);
+		ctx->checkpoint_at = 0;
+	}
+}
+
+/*
+	Adds the issue stage of a clock cycle to the stats, for cycles clock cycles in a row of the same state.
+	stalls are the stalls of the cycle, an issued instruction isn't a stall and neither is an empty queue.
+*/
+void countIssue(Sim_ctx *ctx, int issued, int *stalls, int cycles) {
+	int c;
+	if (issued) {
+		ctx->stats.issue_cycles += cycles;
+	}
+	else if (ctx->iq.next_issue == ctx->iq.tail) {
+		ctx->stats.empty_cycles += cycles;
+	}
+	for (c = 0; c < STALL_CAUSES; c++) {
+		ctx->stats.stalls[c] += (long long)stalls[c] * cycles;
+	}
+}
+
+// Adds the end of a clock cycle to the stats, after retired instructions were retired.
+void countCycle(Sim_ctx *ctx, int retired) {
+	ctx->stats.cycles++;
+	ctx->stats.insts += retired;
+	ctx->stats.queue_hist[ctx->iq.tail - ctx->iq.head]++;
+}
+
+/*
+	Fetches up to width instructions into the queue, until halt (or the sampled fetch limit) or a full queue.
+	Returns 1 if an instruction was fetched or halt was just reached.
+*/
+int fetchInsts(Sim_ctx *ctx, int width) {
+	int changed = 0, fetched = 1;
+	for (; width > 0 && fetched; width--) {
+		if (ctx->inst_num != ctx->fetch_limit && memRead(&ctx->mem, ctx->inst_num) != HALT_INST) {
+			fetched = fetch(&ctx->iq, memRead(&ctx->mem, ctx->inst_num));
+			ctx->inst_num += fetched;
+			changed |= fetched;
+		}
+		else {
+			changed |= !ctx->halt_reached;
+			ctx->halt_reached = 1;
+			break;
+		}
+	}
+	return changed;
+}
+
+/*
+	Does the first fetch and issue of an initialized context, before the simulation starts to run.
+	A context restored from a checkpoint is already running.
+*/
+void startSimulation(Sim_ctx *ctx) {
+	int stalls[STALL_CAUSES] = { 0 };
+	if (ctx->cc == 1) {
+		checkpointCycle(ctx);
+		ctx->inst_num += fetch(&ctx->iq, memRead(&ctx->mem, ctx->inst_num));
+		fetchInsts(ctx, ctx->fetch_width - 1);
+		if (ctx->tomasulo) {
+			countIssue(ctx, tomIssue(ctx->F, ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, ctx->issue_width, stalls), stalls, 1);
+		}
+		else {
+			countIssue(ctx, issue(ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, ctx->issue_width, stalls), stalls, 1);
+		}
+		ctx->cc++;
+		countCycle(ctx, 0);
+	}
+}
+
+/*
+	Simulates a clock cycle of a started context.
+	In event driven mode a quiet cycle is followed by the cycles skipped until the next unit completes.
+	Returns 0 once all of the instructions up to halt were printed.
+*/
+int simulateCycle(Sim_ctx *ctx, Trace_set *traced, int event_driven, Trace_file *trace_inst, Trace_file *trace_unit) {
+	// Flag to indicates if the simulation is running
+	int sim = 1;
+	// Per cycle flag of whether the state changed.
+	int changed = 0;
+	// Cycles until the first counting down unit completes or the first held pipelined unit may start, and cycles to skip to get there.
+	int next_event = -1, next_start = -1, skip = 0;
+	// Queue head before retiring, to tell if an instruction was retired.
+	int retired = 0;
+	// Bitmask of the registers released by the write back this cycle.
+	int released_regs = 0;
+	// Stalls of this cycle by cause, and whether an instruction was issued.
+	int stalls[STALL_CAUSES] = { 0 };
+	int issued;
+
+	checkpointCycle(ctx);
+
+	if (traced != NULL) {
+		traceUnits(trace_unit, &ctx->fu, traced, ctx->cc, 1);
+	}
+
+	changed |= fetchInsts(ctx, ctx->fetch_width);
+	if (ctx->tomasulo) {
+		issued = tomIssue(ctx->F, ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, ctx->issue_width, stalls);
+		changed |= issued > 0;
+		changed |= tomRead(&ctx->iq, ctx->cc, &ctx->fu, &next_start, stalls);
+		changed |= tomExec(&ctx->iq, ctx->cc, &ctx->fu, &ctx->mem, ctx->legacy_float, &next_event);
+		changed |= tomWrite(ctx->F, ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, ctx->issue_width, stalls);
+	}
+	else {
+		issued = issue(ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, ctx->issue_width, stalls);
+		changed |= issued > 0;
+		changed |= readOper(ctx->F, ctx->busy_type, ctx->busy_idx, ctx->iq.q, ctx->cc, &ctx->fu, &next_start, stalls);
+		changed |= execComp(ctx->F, ctx->busy_type, ctx->busy_idx, &ctx->iq, ctx->cc, &ctx->fu, &ctx->mem, ctx->legacy_float, &next_event, stalls, &released_regs);
+		changed |= writeBack(ctx->F, ctx->busy_type, ctx->busy_idx, ctx->iq.q, ctx->cc, &ctx->fu, &released_regs);
+		changed |= clearBusyReg(&ctx->fu, released_regs);
+	}
+	if (next_start != -1) {
+		noteCountdown(&next_event, next_start);
+	}
+
+	ctx->cc++;
+
+	retired = ctx->iq.head;
+	sim = retireInst(trace_inst, &ctx->iq, ctx->halt_reached, ctx->issue_width);
+	// Retiring frees a queue spot, so a stalled fetch can continue the next cycle.
+	changed |= ctx->iq.head != retired && !ctx->halt_reached;
+	if (ctx->iq.head == ctx->mark_retired && ctx->mark_cc == 0) {
+		ctx->mark_cc = ctx->cc;
+	}
+	countCycle(ctx, ctx->iq.head - retired);
+
+	// Event driven mode: a cycle in which the units only counted down repeats itself until the first of them completes.
+	// Jumping straight to that cycle, the traced unit and the instructions printing are stepped through the skipped cycles.
+	// The jump stops early at the checkpoint cycle.
+	if (event_driven && sim && !changed && next_event > 1) {
+		for (skip = 0; skip < next_event - 1 && sim && !changed && ctx->cc != ctx->checkpoint_at; skip++) {
+			ctx->cc++;
+			retired = ctx->iq.head;
+			sim = retireInst(trace_inst, &ctx->iq, ctx->halt_reached, ctx->issue_width);
+			changed = ctx->iq.head != retired && !ctx->halt_reached;
+			if (ctx->iq.head == ctx->mark_retired && ctx->mark_cc == 0) {
+				ctx->mark_cc = ctx->cc;
+			}
+			countCycle(ctx, ctx->iq.head - retired);
+		}
+		if (traced != NULL) {
+			traceUnits(trace_unit, &ctx->fu, traced, ctx->cc - skip, skip);
+		}
+		skipUnitArr(&ctx->fu, ctx->iq.q, skip);
+	}
+	// The skipped cycles had the same stalls, nothing changed in them
+	countIssue(ctx, issued, stalls, 1 + skip);
+
+	return sim;
+}
+
+/*
+	Runs the simulation of an initialized context, or of one restored from a checkpoint, until all of the instructions up to halt were printed.
+	The checkpoint of the context is saved on its way if it has one.
+	traced is the set of units to trace. traced, trace_inst and trace_unit may be NULL to skip the trace files.
+	Returns the number of clock cycles the simulation took.
+*/
+int simulate(Sim_ctx *ctx, Trace_set *traced, int event_driven, Trace_file *trace_inst, Trace_file *trace_unit) {
+	if (trace_unit == NULL) {
+		traced = NULL;
+	}
+
+	startSimulation(ctx);
+	while (simulateCycle(ctx, traced, event_driven, trace_inst, trace_unit));
+
+	return ctx->cc - 1;
+}
+
+/*
+	Functional simulation, executes the instructions one at a time in program order straight on the registers and the memory,
+	without the instructions queue, the units and the scoreboard. For when only the final registers and memory are needed.
+	Stops at halt, or after max_insts instructions (-1 for no limit).
+	Returns the number of executed instructions, -1 if an instruction has an unknown opcode.
+*/
+int simulateFunctional(Sim_ctx *ctx, int max_insts) {
+	float *F = ctx->F;
+	Inst inst;
+	int word, executed = 0;
+
+	while (executed != max_insts && (word = memRead(&ctx->mem, ctx->inst_num)) != HALT_INST) {
+		inst = createInst(word);
+		if (ctx->fu.base_addressing && (inst.opcode == OP_LD || inst.opcode == OP_ST)) {
+			inst.addr = (unsigned int)inst.imm + floatToAddr(F[inst.src0]);
+		}
+		switch (inst.opcode) {
+		case OP_LD:
+			F[inst.dst] = ctx->legacy_float ? single_pre_to_float_legacy(memRead(&ctx->mem, inst.addr)) : single_pre_to_float(memRead(&ctx->mem, inst.addr));
+			break;
+		case OP_ST:
+			memWrite(&ctx->mem, inst.addr, ctx->legacy_float ? floatToSinglePre_legacy(F[inst.src1]) : floatToSinglePre(F[inst.src1]), 1);
+			break;
+		case OP_ADD:
+			F[inst.dst] = F[inst.src0] + F[inst.src1];
+			break;
+		case OP_SUB:
+			F[inst.dst] = F[inst.src0] - F[inst.src1];
+			break;
+		case OP_MULT:
+			F[inst.dst] = F[inst.src0] * F[inst.src1];
+			break;
+		case OP_DIV:
+			F[inst.dst] = F[inst.src0] / F[inst.src1];
+			break;
+		default: // The cycle simulation would never issue it
+			printf("unknown opcode %d at address %d\n", inst.opcode, ctx->inst_num);
+			return -1;
+		}
+		ctx->inst_num++;
+		executed++;
+	}
+	ctx->halt_reached = memRead(&ctx->mem, ctx->inst_num) == HALT_INST;
+	return executed;
+}
+
+/*
+	Sampled simulation, for programs too long to simulate every cycle of.
+	Every sample period of instructions starts with a detailed window: the cycle simulation of warmup instructions to fill the units,
+	then of window instructions whose cycles per instruction are measured. The rest of the period is fast forwarded functionally.
+	The total cycles are extrapolated from the mean cycles per instruction of the windows, with a 95% confidence interval
+	from their spread, and printed. The estimate and the interval (percent of the estimate) are also returned through estimate
+	and interval, the estimate is 0 if no window was measured.
+	Returns 0 if the sample sizes are invalid or the functional simulation failed.
+*/
+int simulateSampled(Sim_ctx *ctx, int period, int warmup, int window, int event_driven, double *estimate, double *interval) {
+	int start, cycles, executed, measured, windows = 0;
+	double cpi, sum = 0, sum_sq = 0, total = 0, mean, error = 0;
+
+	*estimate = 0;
+	*interval = 0;
+	if (window <= 0 || warmup < 0 || period < warmup + window) {
+		printf("sample_window must be positive and sample_period at least sample_warmup + sample_window\n");
+		return 0;
+	}
+	while (memRead(&ctx->mem, ctx->inst_num) != HALT_INST) {
+		// Detailed window, from empty units and queue, the fetch stops after the window as if it reached halt
+		resetPipeline(ctx);
+		start = ctx->inst_num;
+		ctx->fetch_limit = start + warmup + window;
+		ctx->mark_retired = warmup;
+		ctx->mark_cc = 0;
+		cycles = simulate(ctx, NULL, event_driven, NULL, NULL);
+		measured = ctx->inst_num - start - warmup;
+		total += ctx->inst_num - start;
+		if (measured > 0) {
+			cpi = (double)(cycles - (ctx->mark_cc - 1)) / measured;
+			sum += cpi;
+			sum_sq += cpi * cpi;
+			windows++;
+		}
+		ctx->fetch_limit = 0;
+
+		// Fast forward to the next period
+		if (memRead(&ctx->mem, ctx->inst_num) != HALT_INST) {
+			executed = simulateFunctional(ctx, period - warmup - window);
+			if (executed < 0) {
+				return 0;
+			}
+			total += executed;
+		}
+	}
+	ctx->halt_reached = 1;
+
+	if (windows == 0) {
+		printf("%.0f instructions, no sample window reached past its warmup\n", total);
+		return 1;
+	}
+	mean = sum / windows;
+	if (windows > 1) {
+		error = 1.96 * sqrt((sum_sq - sum * mean) / (windows - 1) / windows);
+	}
+	*estimate = mean * total;
+	*interval = mean > 0 ? 100 * error / mean : 0.0;
+	printf("%.0f instructions, %d sample windows: about %.0f cycles (+-%.1f%%), %.3f cycles per instruction\n",
+		total, windows, *estimate, *interval, mean);
+	return 1;
+}
+
+/*
+	Pipelined units, the *_pipelined and *_ii cfg keys.
+	A pipelined unit starts an instruction every ii cycles at most, and keeps up to delay / ii instructions (rounded up) in flight,
+	each in a slot of its own from issue to write back. The ii is at most the delay, a longer one is the same as not pipelined.
+*/
+int unitII(const Sim_config *cfg, int type, int delay) {
+	return cfg->ii[type] < delay ? cfg->ii[type] : delay;
+}
+
+int unitSlots(const Sim_config *cfg, int type, int delay) {
+	if (!cfg->pipelined[type]) {
+		return 1;
+	}
+	return (delay + unitII(cfg, type, delay) - 1) / unitII(cfg, type, delay);
+}
+
+// Inserts the units of the config into the empty table, in the order of fu_order.
+// A pipelined unit with a delay of the type is in the table as its slots, see unitSlots.
+void insertUnits(Unit_table *fu, const Sim_config *cfg) {
+	int i, n, slot, type;
+	for (i = 0; i < 6; i++) {
+		type = fu_order[i];
+		fu->units[type] = cfg->units[type];
+		fu->slots[type] = unitSlots(cfg, type, cfg->delays[type]);
+		fu->ii[type] = cfg->pipelined[type] ? unitII(cfg, type, cfg->delays[type]) : 0;
+		for (slot = 0; slot < fu->slots[type]; slot++) {
+			for (n = 0; n < cfg->units[type]; n++) {
+				insert_unit_table(fu, type, cfg->delays[type], n);
+			}
+		}
+	}
+}
+
+/*
+	Writes the stats of the simulated clock cycles, a "name value..." line per number:
+		cycles, instructions, ipc
+		unit NAME busy_cycles utilization%, for every unit (of the slots of a pipelined unit)
+		issue issued/empty cycles and percent of the cycles, the rest are structural stalls
+		stall structural/waw/raw/war count, in instruction cycles (see Sim_stats)
+		queue N cycles percent, the cycles that ended with N instructions in the queue
+		cache load/store hits misses hit_rate%, and cache write_backs count, if the cfg has a data cache
+	A run restored from a checkpoint counts from the restored cycle.
+	Returns 0 if the file couldn't be opened.
+*/
+int writeStats(char *stats_path, Sim_ctx *ctx) {
+	static const char *stall_names[STALL_CAUSES] = { "structural", "waw", "raw", "war" };
+	Sim_stats *st = &ctx->stats;
+	Unit_table *fu = &ctx->fu;
+	FILE *stats;
+	double cycles = st->cycles > 0 ? (double)st->cycles : 1;
+	long long busy, accesses;
+	int type, n, u, i;
+
+	stats = fopen(stats_path, "w");
+	if (stats == NULL) {
+		printf("couldn't open the stats file");
+		return 0;
+	}
+	fprintf(stats, "cycles %lld\n", st->cycles);
+	fprintf(stats, "instructions %lld\n", st->insts);
+	fprintf(stats, "ipc %.4f\n", st->insts / cycles);
+	// A pipelined unit sums the busy cycles of its slots, its utilization is of all of its slots
+	for (i = 0; i < 6; i++) {
+		type = fu_order[i];
+		for (n = 0; n < fu->units[type]; n++) {
+			busy = 0;
+			for (u = fu->first[type] + n; u < fu->first[type] + fu->count[type]; u += fu->units[type]) {
+				busy += fu->busy_cycles[u];
+			}
+			fprintf(stats, "unit %s%d %lld %.2f%%\n", units_names[type], n, busy, 100.0 * busy / cycles / fu->slots[type]);
+		}
+	}
+	fprintf(stats, "issue issued %lld %.2f%%\n", st->issue_cycles, 100.0 * st->issue_cycles / cycles);
+	fprintf(stats, "issue empty %lld %.2f%%\n", st->empty_cycles, 100.0 * st->empty_cycles / cycles);
+	for (i = 0; i < STALL_CAUSES; i++) {
+		fprintf(stats, "stall %s %lld\n", stall_names[i], st->stalls[i]);
+	}
+	for (i = 0; i <= ctx->iq.size; i++) {
+		fprintf(stats, "queue %d %lld %.2f%%\n", i, st->queue_hist[i], 100.0 * st->queue_hist[i] / cycles);
+	}
+	if (fu->cache != NULL) {
+		for (i = 0; i < 2; i++) {
+			accesses = fu->cache->hits[i] + fu->cache->misses[i];
+			fprintf(stats, "cache %s %lld %lld %.2f%%\n", i == 0 ? "load" : "store", fu->cache->hits[i], fu->cache->misses[i],
+				100.0 * fu->cache->hits[i] / (accesses > 0 ? accesses : 1));
+		}
+		fprintf(stats, "cache write_backs %lld\n", fu->cache->write_backs);
+	}
+	fclose(stats);
+	return 1;
+}
+
+/*
+	Checks a sampled estimate against the full detailed simulation of the memin, and prints how far off it was
+	and whether the cycles are within its confidence interval.
+	Returns 0 if the memin couldn't be read.
+*/
+int checkSampledEstimate(Run_cfg *cfg, char *memin_path, double estimate, double interval) {
+	Sim_ctx *ctx;
+	double off;
+	int cycles;
+
+	ctx = (Sim_ctx*)calloc(1, sizeof(Sim_ctx));
+	if (ctx == NULL) {
+		printf("Fail to calloc the simulation context\n");
+		return 0;
+	}
+	init_unit_table(&ctx->fu, 1);
+	insertUnits(&ctx->fu, &cfg->sim);
+	initSimCtx(ctx, cfg->sim.queue_depth);
+	configureSimCtx(ctx, &cfg->sim);
+	init_mem(&ctx->mem, cfg->sim.mem_addr_bits);
+	if (!readMemin(memin_path, &ctx->mem)) {
+		freeSimCtx(ctx);
+		free_mem(&ctx->mem);
+		free(ctx);
+		return 0;
+	}
+	cycles = simulate(ctx, NULL, cfg->sim.event_driven, NULL, NULL);
+	off = 100 * (estimate - cycles) / cycles;
+	printf("full detailed run: %d cycles, the estimate is off by %+.1f%%, %s its confidence interval\n",
+		cycles, off, fabs(off) <= interval ? "within" : "outside");
+	freeSimCtx(ctx);
+	free_mem(&ctx->mem);
+	free(ctx);
+	return 1;
+}
+
+/*
+	Runs a single simulation of a parsed config.
+	paths holds the 6 files of the run in the order of the command line: cfg, memin, memout, regout, traceinst, traceunit.
+	All of the run state is kept in its own context, so runs can go on side by side on different threads.
+	Returns 1 on success, 0 if the run failed.
+*/
+int runSimulationCfg(Run_cfg *cfg, char **paths) {
+	// Declarations
+	Sim_ctx *ctx;
+	int i;
+	// The units to trace
+	Trace_set traced;
+	int res;
+	// Checkpoint to resume from
+	char *checkpoint = NULL;
+	size_t checkpoint_len;
+	// Sampled estimate of the cycles and its confidence interval
+	double estimate, interval;
+
+	// File pointers
+	Trace_file trace_inst;
+	Trace_file trace_unit;
+	FILE* regout;
+
+	//Allocations
+	ctx = (Sim_ctx*)calloc(1, sizeof(Sim_ctx));
+	if (ctx == NULL) {
+		printf("Fail to calloc the simulation context\n");
+		return 0;
+	}
+
+	//Initialization
+	init_unit_table(&ctx->fu, 1);
+	insertUnits(&ctx->fu, &cfg->sim);
+	initSimCtx(ctx, cfg->sim.queue_depth);
+	configureSimCtx(ctx, &cfg->sim);
+
+	// Resuming from a checkpoint instead of the memin, the memory is the checkpoint's
+	if (cfg->restore_from[0] != '\0') {
+		// The restored instructions are half way through the units
+		if (cfg->functional || cfg->sample_period > 0) {
+			printf("a checkpoint can't be restored in functional or sampled mode\n");
+			freeSimCtx(ctx);
+			free(ctx);
+			return 0;
+		}
+		checkpoint = readCheckpoint(cfg->restore_from, &checkpoint_len);
+		res = checkpoint != NULL && restoreCheckpoint(ctx, checkpoint);
+		free(checkpoint);
+		if (!res) {
+			freeSimCtx(ctx);
+			free_mem(&ctx->mem);
+			free(ctx);
+			return 0;
+		}
+	}
+	else {
+		//Scaning input memory to MEM
+		init_mem(&ctx->mem, cfg->sim.mem_addr_bits);
+		if (!readMemin(paths[1], &ctx->mem)) {
+			freeSimCtx(ctx);
+			free_mem(&ctx->mem);
+			free(ctx);
+			return 0;
+		}
+	}
+
+	if (!openTrace(&trace_inst, paths[4], "SBTI")) {
+		printf("couldn't open the traceinst file");
+		freeSimCtx(ctx);
+		free_mem(&ctx->mem);
+		free(ctx);
+		return 0;
+	}
+	if (!openTrace(&trace_unit, paths[5], "SBTU")) {
+		printf("couldn't open the trace_unit file");
+		closeTrace(&trace_inst);
+		freeSimCtx(ctx);
+		free_mem(&ctx->mem);
+		free(ctx);
+		return 0;
+	}
+
+	getTraceUnits(cfg, &ctx->fu, &traced);
+
+	if (cfg->checkpoint_file[0] != '\0') {
+		ctx->checkpoint_at = cfg->checkpoint_at;
+		strcpy(ctx->checkpoint_path, cfg->checkpoint_file);
+	}
+	// Functional and sampled modes only run the program for the regout and memout, the trace files are left empty
+	res = 1;
+	if (cfg->functional) {
+		res = simulateFunctional(ctx, -1) >= 0;
+	}
+	else if (cfg->sample_period > 0) {
+		ctx->checkpoint_at = 0;
+		res = simulateSampled(ctx, cfg->sample_period, cfg->sample_warmup, cfg->sample_window, cfg->sim.event_driven, &estimate, &interval);
+		if (res && cfg->sample_check && estimate > 0) {
+			res = checkSampledEstimate(cfg, paths[1], estimate, interval);
+		}
+	}
+	else {
+		simulate(ctx, &traced, cfg->sim.event_driven, &trace_inst, &trace_unit);
+		if (cfg->stats_file[0] != '\0') {
+			res = writeStats(cfg->stats_file, ctx);
+		}
+	}
+	free(traced.units);
+
+	closeTrace(&trace_inst);
+	closeTrace(&trace_unit);
+	freeSimCtx(ctx);
+	if (!res) {
+		free_mem(&ctx->mem);
+		free(ctx);
+		return 0;
+	}
+
+	regout = fopen(paths[3], "w");
+	if (regout == NULL) {
+		printf("couldn't open the regout file");
+		free_mem(&ctx->mem);
+		free(ctx);
+		return 0;
+	}
+	for (i = 0; i < REGS_NUM; i++) {
+		fprintf(regout, "%f\n", ctx->F[i]);
+	}
+	fclose(regout);
+
+	res = writeMemout(paths[2], &ctx->mem, cfg->memout_sparse);
+	free_mem(&ctx->mem);
+	free(ctx);
+
+	return res;
+}
+
+/*
+	Runs a single simulation, parsing its cfg file first. See runSimulationCfg.
+*/
+int runSimulation(char **paths) {
+	Run_cfg cfg;
+	if (!parseCfg(paths[0], &cfg)) {
+		return 0;
+	}
+	return runSimulationCfg(&cfg, paths);
+}
+
+/*
+	Library API, see sim.h.
+	A simulator is a simulation context, with its instructions trace kept in memory.
+*/
+struct Sim {
+	Sim_ctx ctx;
+	Trace_file insts;
+	int event_driven;
+	// 0 once the simulation ended
+	int running;
+};
+
+void simDefaultConfig(Sim_config *cfg, int units, int delay) {
+	int i;
+	for (i = 0; i < 6; i++) {
+		cfg->units[i] = units;
+		cfg->delays[i] = delay;
+		cfg->pipelined[i] = 0;
+		cfg->ii[i] = 1;
+	}
+	cfg->mem_addr_bits = MEM_ADDR_BITS;
+	cfg->base_addressing = 0;
+	cfg->legacy_float = 0;
+	cfg->fetch_width = 1;
+	cfg->issue_width = 1;
+	cfg->queue_depth = QUEUE_DEPTH;
+	cfg->event_driven = 0;
+	cfg->tomasulo = 0;
+	cfg->mem_disambiguation = 0;
+	cfg->cache_size = 0;
+	cfg->cache_line = CACHE_LINE;
+	cfg->cache_ways = 1;
+	cfg->cache_policy = CACHE_LRU;
+	cfg->cache_hit_delay = 1;
+	cfg->cache_miss_delay = 0;
+}
+
+int simReadConfig(char *cfg_path, Sim_config *cfg) {
+	Run_cfg run_cfg;
+	if (!parseCfg(cfg_path, &run_cfg)) {
+		return 0;
+	}
+	*cfg = run_cfg.sim;
+	return 1;
+}
+
+Sim *simCreate(const Sim_config *cfg, const int *mem, unsigned int words) {
+	Sim *sim;
+	unsigned int addr;
+
+	if (!checkSimConfig(cfg)) {
+		return NULL;
+	}
+	sim = (Sim*)calloc(1, sizeof(Sim));
+	if (sim == NULL) {
+		printf("Fail to calloc the simulation context\n");
+		return NULL;
+	}
+	init_unit_table(&sim->ctx.fu, 1);
+	insertUnits(&sim->ctx.fu, cfg);
+	initSimCtx(&sim->ctx, cfg->queue_depth);
+	configureSimCtx(&sim->ctx, cfg);
+	init_mem(&sim->ctx.mem, cfg->mem_addr_bits);
+	for (addr = 0; addr < words && addr <= sim->ctx.mem.addr_mask; addr++) {
+		memWrite(&sim->ctx.mem, addr, mem[addr], 0);
+	}
+	sim->event_driven = cfg->event_driven;
+	sim->running = 1;
+	return sim;
+}
+
+void simDestroy(Sim *sim) {
+	if (sim == NULL) {
+		return;
+	}
+	closeTrace(&sim->insts);
+	freeSimCtx(&sim->ctx);
+	free_mem(&sim->ctx.mem);
+	free(sim);
+}
+
+int simStep(Sim *sim, int cycles) {
+	if (sim->running && cycles > 0 && sim->ctx.cc == 1) {
+		startSimulation(&sim->ctx);
+		cycles--;
+	}
+	for (; sim->running && cycles > 0; cycles--) {
+		sim->running = simulateCycle(&sim->ctx, NULL, 0, &sim->insts, NULL);
+	}
+	return sim->running;
+}
+
+int simRunToHalt(Sim *sim) {
+	if (sim->running) {
+		startSimulation(&sim->ctx);
+		while (simulateCycle(&sim->ctx, NULL, sim->event_driven, &sim->insts, NULL));
+		sim->running = 0;
+	}
+	return sim->ctx.cc - 1;
+}
+
+int simCycles(Sim *sim) {
+	return sim->ctx.cc - 1;
+}
+
+float simRegister(Sim *sim, int reg) {
+	return reg >= 0 && reg < REGS_NUM ? sim->ctx.F[reg] : 0;
+}
+
+int simMemory(Sim *sim, unsigned int addr) {
+	return memRead(&sim->ctx.mem, addr);
+}
+
+const Sim_inst_times *simInstTimes(Sim *sim, int *num) {
+	*num = sim->insts.recs_num;
+	return sim->insts.recs;
+}
+
+int simUnitState(Sim *sim, int type, int index, Sim_unit_state *state) {
+	Unit_table *fu = &sim->ctx.fu;
+	int u;
+	if (type < 0 || type > 5 || index < 0 || index >= fu->count[type]) {
+		return 0;
+	}
+	u = fu->first[type] + index;
+	state->busy = fu->busy[u];
+	state->f_i = fu->f_i[u];
+	state->f_j = fu->f_j[u];
+	state->f_k = fu->f_k[u];
+	state->q_j_type = fu->q_j_type[u];
+	state->q_j_idx = fu->q_j_idx[u];
+	state->q_k_type = fu->q_k_type[u];
+	state->q_k_idx = fu->q_k_idx[u];
+	state->r_j = fu->r_j[u];
+	state->r_k = fu->r_k[u];
+	state->remain = fu->remain[u];
+	return 1;
+}
+
+/*
+	Batch mode, simulating many runs in one process.
+	Each line of the manifest file is a job with the 6 paths of a run, in the order of the command line.
+	Paths are separated by white spaces, a path with spaces is written in double quotes.
+	Each distinct cfg file is parsed once, before the jobs start.
+*/
+typedef struct {
+	// The 6 paths of each job, jobs[j][0..5]
+	char (*jobs)[6][MAX_LINE_LENGTH];
+	// Index in cfgs of the config of each job
+	int *job_cfg;
+	Cfg_cache cfgs;
+	int jobs_num;
+	// Index of the next job to run, taken by the workers one at a time
+	volatile long next_job;
+	// Number of jobs that failed
+	volatile long failed;
+} Batch;
+
+// Atomically increments the input counter and returns its value before the increment.
+long fetchAndIncrement(volatile long *counter) {
+#ifdef _WIN32
+	return InterlockedIncrement(counter) - 1;
+#else
+	return __sync_fetch_and_add(counter, 1);
+#endif
+}
+
+// Wall clock time in seconds, for the batch throughput.
+double wallTime() {
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+// Number of processors, the default number of batch workers.
+int processorsNum() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+#ifdef _WIN32
+typedef DWORD (WINAPI *Worker_func)(LPVOID);
+#else
+typedef void *(*Worker_func)(void *);
+#endif
+
+/*
+	Runs workers_num threads of the input worker function over the shared arg, and waits for all of them to finish.
+*/
+void runWorkers(Worker_func worker, void *arg, int workers_num) {
+	int w;
+#ifdef _WIN32
+	HANDLE *workers = malloc(workers_num * sizeof(*workers));
+	for (w = 0; w < workers_num; w++) {
+		workers[w] = CreateThread(NULL, 0, worker, arg, 0, NULL);
+	}
+	for (w = 0; w < workers_num; w++) {
+		WaitForSingleObject(workers[w], INFINITE);
+		CloseHandle(workers[w]);
+	}
+#else
+	pthread_t *workers = malloc(workers_num * sizeof(*workers));
+	for (w = 0; w < workers_num; w++) {
+		pthread_create(&workers[w], NULL, worker, arg);
+	}
+	for (w = 0; w < workers_num; w++) {
+		pthread_join(workers[w], NULL);
+	}
+#endif
+	free(workers);
+}
+
+/*
+	Batch worker, takes the next job until there are no more jobs.
+*/
+#ifdef _WIN32
+DWORD WINAPI batchWorker(LPVOID arg) {
+#else
+void *batchWorker(void *arg) {
+#endif
+	Batch *batch = (Batch*)arg;
+	char *paths[6];
+	long j;
+	int i;
+	while ((j = fetchAndIncrement(&batch->next_job)) < batch->jobs_num) {
+		for (i = 0; i < 6; i++) {
+			paths[i] = batch->jobs[j][i];
+		}
+		if (!runSimulationCfg(&batch->cfgs.cfgs[batch->job_cfg[j]], paths)) {
+			fetchAndIncrement(&batch->failed);
+		}
+	}
+	return 0;
+}
+
+/*
+	Reads the next path of a manifest line starting at *pos into path.
+	Returns 0 if there is no more path in the line.
+*/
+int readManifestPath(char **pos, char *path) {
+	char *p = *pos;
+	int len = 0;
+	char end = ' ';
+	while (*p != '\0' && isspace((unsigned char)*p)) {
+		p++;
+	}
+	if (*p == '\0') {
+		return 0;
+	}
+	if (*p == '"') {
+		end = '"';
+		p++;
+	}
+	while (*p != '\0' && len < MAX_LINE_LENGTH - 1 && (end == '"' ? *p != '"' : !isspace((unsigned char)*p))) {
+		path[len++] = *p++;
+	}
+	if (*p == '"') {
+		p++;
+	}
+	path[len] = '\0';
+	*pos = p;
+	return 1;
+}
+
+/*
+	Runs all of the jobs of the manifest file over workers_num worker threads (0 for one per processor).
+	Prints the number of jobs and the aggregate jobs per second.
+	Returns 1 if all of the jobs succeeded.
+*/
+int runBatch(char *manifest_path, int workers_num) {
+	Batch batch;
+	FILE *manifest;
+	char line[6 * MAX_LINE_LENGTH];
+	char *pos;
+	int size = 16, i, j, cfg;
+	double start, elapsed;
+
+	manifest = fopen(manifest_path, "r");
+	if (manifest == NULL) {
+		printf("couldn't open the manifest file");
+		return 0;
+	}
+	batch.jobs = malloc(size * sizeof(*batch.jobs));
+	batch.jobs_num = 0;
+	batch.next_job = 0;
+	batch.failed = 0;
+	memset(&batch.cfgs, 0, sizeof(Cfg_cache));
+	while (fgets(line, sizeof(line), manifest) != NULL) {
+		if (batch.jobs_num == size) {
+			size *= 2;
+			batch.jobs = realloc(batch.jobs, size * sizeof(*batch.jobs));
+		}
+		pos = line;
+		for (i = 0; i < 6 && readManifestPath(&pos, batch.jobs[batch.jobs_num][i]); i++);
+		if (i == 0) { // Empty line
+			continue;
+		}
+		if (i < 6) {
+			printf("manifest line %d doesn't have 6 paths\n", batch.jobs_num + 1);
+			batch.failed++;
+			continue;
+		}
+		batch.jobs_num++;
+	}
+	fclose(manifest);
+
+	// Jobs with a bad cfg fail here and are dropped
+	batch.job_cfg = (int*)malloc((batch.jobs_num + 1) * sizeof(int));
+	for (i = 0, j = 0; i < batch.jobs_num; i++) {
+		cfg = getCachedCfg(&batch.cfgs, batch.jobs[i][0]);
+		if (cfg == -1) {
+			batch.failed++;
+			continue;
+		}
+		if (j != i) {
+			memcpy(batch.jobs[j], batch.jobs[i], sizeof(*batch.jobs));
+		}
+		batch.job_cfg[j++] = cfg;
+	}
+	batch.jobs_num = j;
+
+	if (workers_num <= 0) {
+		workers_num = processorsNum();
+	}
+	if (workers_num > batch.jobs_num) {
+		workers_num = batch.jobs_num > 0 ? batch.jobs_num : 1;
+	}
+
+	start = wallTime();
+	runWorkers(batchWorker, &batch, workers_num);
+	elapsed = wallTime() - start;
+
+	printf("%d jobs (%ld failed) on %d workers in %.3f sec, %.1f jobs/sec\n", batch.jobs_num, batch.failed, workers_num, elapsed, elapsed > 0 ? batch.jobs_num / elapsed : 0.0);
+
+	free(batch.jobs);
+	free(batch.job_cfg);
+	freeCfgCache(&batch.cfgs);
+	return batch.failed == 0;
+}
+
+/*
+	Design space sweep, simulating one program over the cartesian product of the units numbers and delays.
+	In the sweep cfg each of the units numbers and delays may be a single value, a range "1..4" or a list "{10,20,40}".
+	With restore_from in the sweep cfg every point resumes from that checkpoint instead of the memin, so a long prefix
+	which is the same in all of the points (e.g. before the swept units are first used) is simulated only once.
+*/
+typedef struct {
+	// values[2 * type] are the units numbers to sweep of the type, values[2 * type + 1] are its delays.
+	int values[12][SWEEP_MAX_VALUES];
+	int values_num[12];
+	int points_num;
+	// The memory image, parsed once and copied by each point.
+	Sim_mem mem_image;
+	// The checkpoint all of the points are restored from, NULL to start from the memory image.
+	char *checkpoint;
+	// The rest of the keys of the sweep cfg
+	Run_cfg cfg;
+	// Total clock cycles of each point
+	int *cycles;
+	// Index of the next point to simulate, taken by the workers one at a time
+	volatile long next_point;
+} Sweep;
+
+// A sweep point for the pareto sorting, by total units then by cycles.
+typedef struct {
+	int units;
+	int cycles;
+	int point;
+} Sweep_result;
+
+/*
+	Parses a sweep cfg value into values: "n", "a..b" or "{a,b,...}".
+	Returns the number of values, 0 if the value is invalid.
+*/
+int parseSweepValues(char *text, int *values) {
+	int num = 0, first, last;
+	char *end;
+
+	while (isspace((unsigned char)*text)) {
+		text++;
+	}
+	if (*text == '{') {
+		text++;
+		while (num < SWEEP_MAX_VALUES) {
+			values[num] = strtol(text, &end, 10);
+			if (end == text) {
+				return 0;
+			}
+			num++;
+			text = end;
+			while (isspace((unsigned char)*text)) {
+				text++;
+			}
+			if (*text == '}') {
+				return num;
+			}
+			if (*text != ',') {
+				return 0;
+			}
+			text++;
+		}
+		return 0;
+	}
+
+	first = strtol(text, &end, 10);
+	if (end == text) {
+		return 0;
+	}
+	last = first;
+	if (end[0] == '.' && end[1] == '.') {
+		text = end + 2;
+		last = strtol(text, &end, 10);
+		if (end == text || last < first || last - first >= SWEEP_MAX_VALUES) {
+			return 0;
+		}
+	}
+	for (; first <= last; first++) {
+		values[num++] = first;
+	}
+	return num;
+}
+
+/*
+	Reads the units numbers and delays to sweep from the cfg file.
+	Returns 0 if a value is missing or invalid.
+*/
+int readSweepCfg(char *cfg_path, Sweep *sweep) {
+	FILE* config;
+	char line[BUF_SIZE];
+	char *key, *value;
+	int type, k, v, values, line_num = 0, ok = 1;
+
+	for (k = 0; k < 12; k++) {
+		sweep->values_num[k] = 0;
+	}
+	initRunCfg(&sweep->cfg);
+
+	config = fopen(cfg_path, "r");
+	if (config == NULL) {
+		printf("couldn't open the config file %s\n", cfg_path);
+		return 0;
+	}
+	while (fgets(line, BUF_SIZE, config) != NULL) {
+		line_num++;
+		v = splitCfgLine(line, &key, &value);
+		if (v == 0) {
+			continue;
+		}
+		k = v == 1 ? findCfgKey(cfg_keys, CFG_KEYS_NUM, key) : -1;
+		if (k == -1) {
+			printf(v == 1 ? "%s:%d: unknown key %s\n" : "%s:%d: expected \"key = value\"\n", cfg_path, line_num, key);
+			ok = 0;
+		}
+		else if (k < CFG_UNIT_KEYS) { // Units numbers by type, then delays by type
+			values = k < 6 ? 2 * k : 2 * (k - 6) + 1;
+			sweep->values_num[values] = parseSweepValues(value, sweep->values[values]);
+			if (sweep->values_num[values] == 0) {
+				printf("%s:%d: invalid sweep value \"%s\" of %s\n", cfg_path, line_num, value, key);
+				ok = 0;
+			}
+		}
+		else if (!setCfgValue(&sweep->cfg, &cfg_keys[k], value)) {
+			printf("%s:%d: invalid value \"%s\" of %s\n", cfg_path, line_num, value, key);
+			ok = 0;
+		}
+	}
+	fclose(config);
+	if (!ok || !checkCacheConfig(&sweep->cfg.sim)) {
+		return 0;
+	}
+
+	sweep->points_num = 1;
+	for (k = 0; k < 12; k++) {
+		type = k / 2;
+		if (sweep->values_num[k] == 0) {
+			printf("%s: missing %s%s\n", cfg_path, units_names_low[type], k % 2 == 0 ? "_nr_units" : "_delay");
+			return 0;
+		}
+		for (v = 0; v < sweep->values_num[k]; v++) {
+			// A type with no units would stall its instructions forever, and so would a unit with no delay.
+			if (sweep->values[k][v] < 1) {
+				printf("error at the sweep values of type: %s\n", units_names[type]);
+				return 0;
+			}
+		}
+		if (sweep->points_num > SWEEP_MAX_POINTS / sweep->values_num[k]) {
+			printf("too many sweep points, the limit is %d\n", SWEEP_MAX_POINTS);
+			return 0;
+		}
+		sweep->points_num *= sweep->values_num[k];
+	}
+	return 1;
+}
+
+/*
+	Decodes the units numbers and delays of a sweep point, the point index is a mixed radix number over the sweep values.
+*/
+void sweepPoint(Sweep *sweep, int point, int *units, int *delays) {
+	int k, v;
+	for (k = 11; k >= 0; k--) {
+		v = sweep->values[k][point % sweep->values_num[k]];
+		point /= sweep->values_num[k];
+		if (k % 2 == 0) {
+			units[k / 2] = v;
+		}
+		else {
+			delays[k / 2] = v;
+		}
+	}
+}
+
+/*
+	Checks that every sweep point has the busy units of the checkpoint, and that its queued instructions fit the queue_depth of the sweep.
+	Returns 0 if a point has less units of a type than the checkpoint uses, or less slots of a pipelined unit.
+*/
+int checkSweepCheckpoint(Sweep *sweep) {
+	Checkpoint_header hdr;
+	Checkpoint_unit unit;
+	int i, v;
+
+	memcpy(&hdr, sweep->checkpoint + 4, sizeof(hdr));
+	if (hdr.tomasulo != sweep->cfg.sim.tomasulo) {
+		printf("the checkpoint was saved by the %s engine\n", hdr.tomasulo ? "tomasulo" : "scoreboard");
+		return 0;
+	}
+	if (hdr.tail - hdr.head > sweep->cfg.sim.queue_depth) {
+		printf("the checkpoint has %d queued instructions, more than the queue_depth of the sweep\n", hdr.tail - hdr.head);
+		return 0;
+	}
+	for (i = 0; i < hdr.units_num; i++) {
+		memcpy(&unit, sweep->checkpoint + 4 + sizeof(hdr) + (hdr.tail - hdr.head) * sizeof(Inst) + i * sizeof(unit), sizeof(unit));
+		for (v = 0; v < sweep->values_num[2 * unit.type]; v++) {
+			if (sweep->values[2 * unit.type][v] <= unit.index) {
+				printf("the checkpoint unit %s%d doesn't exist in all of the sweep points\n", units_names[unit.type], unit.index);
+				return 0;
+			}
+		}
+		for (v = 0; v < sweep->values_num[2 * unit.type + 1]; v++) {
+			if (unitSlots(&sweep->cfg.sim, unit.type, sweep->values[2 * unit.type + 1][v]) <= unit.slot) {
+				printf("the checkpoint unit %s%d doesn't have its pipeline slots in all of the sweep points\n", units_names[unit.type], unit.index);
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+	Sweep worker, simulates the next point until there are no more points.
+	A point whose checkpoint can't be restored isn't simulated, its cycles are -1.
+*/
+#ifdef _WIN32
+DWORD WINAPI sweepWorker(LPVOID arg) {
+#else
+void *sweepWorker(void *arg) {
+#endif
+	Sweep *sweep = (Sweep*)arg;
+	Sim_ctx *ctx;
+	Sim_config cfg = sweep->cfg.sim;
+	long p;
+
+	ctx = (Sim_ctx*)calloc(1, sizeof(Sim_ctx));
+	if (ctx == NULL) {
+		printf("Fail to calloc the simulation context\n");
+		return 0;
+	}
+	while ((p = fetchAndIncrement(&sweep->next_point)) < sweep->points_num) {
+		sweepPoint(sweep, p, cfg.units, cfg.delays);
+		init_unit_table(&ctx->fu, 1);
+		insertUnits(&ctx->fu, &cfg);
+		initSimCtx(ctx, sweep->cfg.sim.queue_depth);
+		configureSimCtx(ctx, &sweep->cfg.sim);
+		if (sweep->checkpoint != NULL) {
+			if (!restoreCheckpoint(ctx, sweep->checkpoint)) {
+				printf("couldn't restore the checkpoint at sweep point %ld\n", p);
+				sweep->cycles[p] = -1;
+				freeSimCtx(ctx);
+				continue;
+			}
+		}
+		else {
+			memCopy(&ctx->mem, &sweep->mem_image);
+		}
+		sweep->cycles[p] = simulate(ctx, NULL, sweep->cfg.sim.event_driven, NULL, NULL);
+		freeSimCtx(ctx);
+		free_mem(&ctx->mem);
+	}
+	free(ctx);
+	return 0;
+}
+
+int compareSweepResults(const void *a, const void *b) {
+	const Sweep_result *ra = (const Sweep_result*)a;
+	const Sweep_result *rb = (const Sweep_result*)b;
+	if (ra->units != rb->units) {
+		return ra->units - rb->units;
+	}
+	return ra->cycles - rb->cycles;
+}
+
+/*
+	Runs the design space sweep of the cfg file over the program of memin on workers_num worker threads (0 for one per processor).
+	Writes to the table file the total cycles of every point, and marks the pareto optimal points of total units versus cycles.
+	A point that failed has "fail" instead of its cycles and isn't a pareto point.
+	Returns 1 on success, 0 if the table couldn't be written or a point failed.
+*/
+int runSweep(char *cfg_path, char *memin_path, char *table_path, int workers_num) {
+	Sweep *sweep;
+	Sweep_result *results;
+	FILE *table;
+	char *pareto;
+	int units[6], delays[6];
+	int p, i, first, best_cycles = -1, pareto_num = 0, failed_num = 0;
+	double start, elapsed;
+	size_t checkpoint_len;
+
+	sweep = (Sweep*)calloc(1, sizeof(Sweep));
+	if (sweep == NULL) {
+		printf("Fail to calloc the sweep\n");
+		return 0;
+	}
+	if (!readSweepCfg(cfg_path, sweep)) {
+		free(sweep);
+		return 0;
+	}
+	if (sweep->cfg.restore_from[0] != '\0') {
+		sweep->checkpoint = readCheckpoint(sweep->cfg.restore_from, &checkpoint_len);
+		if (sweep->checkpoint == NULL || !checkSweepCheckpoint(sweep)) {
+			free(sweep->checkpoint);
+			free(sweep);
+			return 0;
+		}
+	}
+	else {
+		init_mem(&sweep->mem_image, sweep->cfg.sim.mem_addr_bits);
+		if (!readMemin(memin_path, &sweep->mem_image)) {
+			free_mem(&sweep->mem_image);
+			free(sweep);
+			return 0;
+		}
+	}
+	sweep->cycles = (int*)malloc(sweep->points_num * sizeof(int));
+	if (sweep->cycles == NULL) {
+		printf("Fail to malloc the sweep cycles\n");
+		free_mem(&sweep->mem_image);
+		free(sweep->checkpoint);
+		free(sweep);
+		return 0;
+	}
+	sweep->next_point = 0;
+
+	if (workers_num <= 0) {
+		workers_num = processorsNum();
+	}
+	if (workers_num > sweep->points_num) {
+		workers_num = sweep->points_num;
+	}
+
+	start = wallTime();
+	runWorkers(sweepWorker, sweep, workers_num);
+	elapsed = wallTime() - start;
+
+	// Pareto optimal points: sorted by units then cycles, a point is optimal if it has the least cycles of its units
+	// and strictly less cycles than all of the points with less units.
+	results = (Sweep_result*)malloc(sweep->points_num * sizeof(Sweep_result));
+	pareto = (char*)calloc(sweep->points_num, sizeof(char));
+	for (p = 0; p < sweep->points_num; p++) {
+		sweepPoint(sweep, p, units, delays);
+		results[p].units = 0;
+		for (i = 0; i < 6; i++) {
+			results[p].units += units[i];
+		}
+		results[p].cycles = sweep->cycles[p];
+		results[p].point = p;
+	}
+	qsort(results, sweep->points_num, sizeof(Sweep_result), compareSweepResults);
+	for (first = 0; first < sweep->points_num; first = i) {
+		// The failed points (-1 cycles) are sorted first among the points of their units
+		while (first < sweep->points_num && results[first].cycles < 0) {
+			failed_num++;
+			first++;
+		}
+		for (i = first; i < sweep->points_num && results[i].units == results[first].units; i++) {
+			if (results[i].cycles == results[first].cycles && (best_cycles == -1 || results[i].cycles < best_cycles)) {
+				pareto[results[i].point] = 1;
+				pareto_num++;
+			}
+		}
+		if (first < sweep->points_num && (best_cycles == -1 || results[first].cycles < best_cycles)) {
+			best_cycles = results[first].cycles;
+		}
+	}
+
+	table = fopen(table_path, "w");
+	if (table == NULL) {
+		printf("couldn't open the sweep table file");
+	}
+	else {
+		fprintf(table, "point");
+		for (i = 0; i < 6; i++) {
+			fprintf(table, " %s(units/delay)", units_names[fu_order[i]]);
+		}
+		fprintf(table, " units cycles pareto\n");
+		for (p = 0; p < sweep->points_num; p++) {
+			sweepPoint(sweep, p, units, delays);
+			fprintf(table, "%d", p);
+			for (i = 0; i < 6; i++) {
+				fprintf(table, " %d/%d", units[fu_order[i]], delays[fu_order[i]]);
+			}
+			fprintf(table, " %d", units[0] + units[1] + units[2] + units[3] + units[4] + units[5]);
+			if (sweep->cycles[p] < 0) {
+				fprintf(table, " fail -\n");
+			}
+			else {
+				fprintf(table, " %d %s\n", sweep->cycles[p], pareto[p] ? "*" : "-");
+			}
+		}
+		fclose(table);
+	}
+
+	printf("%d points (%d pareto optimal) on %d workers in %.3f sec, %.1f points/sec\n", sweep->points_num, pareto_num, workers_num, elapsed, elapsed > 0 ? sweep->points_num / elapsed : 0.0);
+	if (failed_num > 0) {
+		printf("%d of the sweep points failed\n", failed_num);
+	}
+
+	free(pareto);
+	free(results);
+	free(sweep->cycles);
+	free_mem(&sweep->mem_image);
+	free(sweep->checkpoint);
+	free(sweep);
+	return table != NULL && failed_num == 0;
+}
+
+/*
+	Synthetic workloads.
+	A workload spec is a file of "key = value" lines, like the cfg, describing a random program:
+		length       number of instructions before the halt
+		seed         seed of the random generator, the same spec always gives the same program
+		ld_mix ...   relative weights of the opcodes (ld_mix, st_mix, add_mix, sub_mix, mul_mix, div_mix)
+		dep_distance mean distance in instructions between a register hazard and the instruction it depends on
+		raw          percent of the sources that read the destination of an earlier instruction
+		waw          percent of the destinations that write the destination of an earlier instruction
+		war          percent of the destinations (of the rest) that write a source of an earlier instruction
+		alias        percent of the loads and stores that use the address of one of the last memory instructions
+		data_words   size of the data region the loads and stores address
+	Registers which are not picked as a hazard are the ones least recently used, so the densities are what the spec says.
+	All of the registers are used, except that nothing writes F0 (0.0), the base register of the loads and stores.
+	The dest field of a store isn't written, it is a random register (which the store still marks busy).
+	The data region is right after the halt when it fits the 12 bits immediate, and it is filled with small floats.
+	A longer program addresses its first data_words words instead, only ones at least GEN_ADDR_LAG instructions back,
+	which were already fetched and so stores don't change the program; memory instructions before that are turned into ADDs.
+	The addresses are absolute, and the same with mem_base_addressing as F0 stays 0.
+*/
+#define GEN_ADDR_LAG 256
+#define GEN_ALIAS_WINDOW 8
+
+typedef struct {
+	int length;
+	int seed;
+	int mix[6];
+	int dep_distance;
+	int raw;
+	int waw;
+	int war;
+	int alias;
+	int data_words;
+} Gen_spec;
+
+static Cfg_key gen_keys[] = {
+	{ "length", CFG_INT, offsetof(Gen_spec, length), 1, (1 << 30) - 1, 0 },
+	{ "seed", CFG_INT, offsetof(Gen_spec, seed), 0, INT_MAX, 0 },
+	{ "ld_mix", CFG_INT, offsetof(Gen_spec, mix[OP_LD]), 0, 1000000, 0 },
+	{ "st_mix", CFG_INT, offsetof(Gen_spec, mix[OP_ST]), 0, 1000000, 0 },
+	{ "add_mix", CFG_INT, offsetof(Gen_spec, mix[OP_ADD]), 0, 1000000, 0 },
+	{ "sub_mix", CFG_INT, offsetof(Gen_spec, mix[OP_SUB]), 0, 1000000, 0 },
+	{ "mul_mix", CFG_INT, offsetof(Gen_spec, mix[OP_MULT]), 0, 1000000, 0 },
+	{ "div_mix", CFG_INT, offsetof(Gen_spec, mix[OP_DIV]), 0, 1000000, 0 },
+	{ "dep_distance", CFG_INT, offsetof(Gen_spec, dep_distance), 1, 1000, 0 },
+	{ "raw", CFG_INT, offsetof(Gen_spec, raw), 0, 100, 0 },
+	{ "waw", CFG_INT, offsetof(Gen_spec, waw), 0, 100, 0 },
+	{ "war", CFG_INT, offsetof(Gen_spec, war), 0, 100, 0 },
+	{ "alias", CFG_INT, offsetof(Gen_spec, alias), 0, 100, 0 },
+	{ "data_words", CFG_INT, offsetof(Gen_spec, data_words), 1, MEM_LENGTH_SIM, 0 },
+};
+
+#define GEN_KEYS_NUM ((int)(sizeof(gen_keys) / sizeof(gen_keys[0])))
+
+/*
+	Parses the workload spec file, the keys it doesn't have keep their defaults.
+	Returns 0 on an error.
+*/
+int parseGenSpec(char *spec_path, Gen_spec *spec) {
+	int i, mix = 0;
+	spec->length = 10000;
+	spec->seed = 1;
+	for (i = 0; i < 6; i++) {
+		spec->mix[i] = 1;
+	}
+	spec->dep_distance = 4;
+	spec->raw = 50;
+	spec->waw = 10;
+	spec->war = 10;
+	spec->alias = 20;
+	spec->data_words = 256;
+	if (!parseKeysFile(spec_path, gen_keys, GEN_KEYS_NUM, spec, NULL)) {
+		return 0;
+	}
+	for (i = 0; i < 6; i++) {
+		mix += spec->mix[i];
+	}
+	if (mix == 0) {
+		printf("%s: all of the opcodes mix weights are 0\n", spec_path);
+		return 0;
+	}
+	return 1;
+}
+
+// Xorshift random generator, the same on every platform unlike rand().
+unsigned int genRandom(unsigned int *state) {
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// Random number in 0..n-1
+int genRandomBelow(unsigned int *state, int n) {
+	return (int)(genRandom(state) % (unsigned int)n);
+}
+
+// Picks the register least recently read or written from first on, the first of them from a random start on a tie.
+int genFreshReg(unsigned int *state, int *last_use, int first) {
+	int r, i, best = -1;
+	int start = genRandomBelow(state, REGS_NUM - first);
+	for (i = 0; i < REGS_NUM - first; i++) {
+		r = first + (start + i) % (REGS_NUM - first);
+		if (best == -1 || last_use[r] < last_use[best]) {
+			best = r;
+		}
+	}
+	return best;
+}
+
+// Number of words of the image of the workload: the program, its halt and the data region if it is after the halt.
+int genImageWords(Gen_spec *spec) {
+	if (spec->length + 1 + spec->data_words <= MEM_LENGTH_SIM) {
+		return spec->length + 1 + spec->data_words;
+	}
+	return spec->length + 1;
+}
+
+/*
+	Generates the image of the workload spec into words, which must have room for genImageWords(spec) words.
+*/
+void generateWorkload(Gen_spec *spec, int *words) {
+	// Per instruction history of the last 2 * dep_distance instructions: destination and sources, -1 for none
+	int hist_size = 2 * spec->dep_distance;
+	int (*hist)[3] = malloc(hist_size * sizeof(*hist));
+	int last_use[REGS_NUM];
+	unsigned int recent_addr[GEN_ALIAS_WINDOW];
+	unsigned int state = (unsigned int)spec->seed * 2654435761u + 1, addr;
+	int recent_num = 0, mix = 0, i, j, d, r, op, dst, srcs_num, data_base, addr_range;
+	int srcs[2];
+	float value;
+
+	for (op = 0; op < 6; op++) {
+		mix += spec->mix[op];
+	}
+	for (r = 0; r < REGS_NUM; r++) {
+		last_use[r] = -1;
+	}
+	data_base = spec->length + 1;
+	if (genImageWords(spec) == spec->length + 1) {
+		data_base = 0;
+	}
+
+	for (i = 0; i < spec->length; i++) {
+		r = genRandomBelow(&state, mix);
+		for (op = 0; r >= spec->mix[op]; op++) {
+			r -= spec->mix[op];
+		}
+		// Addresses the memory instruction can use, see the comment above
+		addr_range = spec->data_words;
+		if (data_base == 0 && i - GEN_ADDR_LAG < addr_range) {
+			addr_range = i - GEN_ADDR_LAG;
+		}
+		if ((op == OP_LD || op == OP_ST) && addr_range <= 0) {
+			op = OP_ADD;
+		}
+
+		// Sources, a RAW hazard reads the destination of the instruction d back, or of the writer before it.
+		// A load has none and a store only reads the src1 it stores.
+		srcs[0] = -1;
+		srcs[1] = -1;
+		srcs_num = op == OP_LD ? 0 : (op == OP_ST ? 1 : 2);
+		for (j = 0; j < srcs_num; j++) {
+			r = -1;
+			if (genRandomBelow(&state, 100) < spec->raw) {
+				for (d = 1 + genRandomBelow(&state, hist_size - 1); d <= hist_size && d <= i && hist[(i - d) % hist_size][0] == -1; d++);
+				if (d <= hist_size && d <= i) {
+					r = hist[(i - d) % hist_size][0];
+				}
+			}
+			if (r == -1) {
+				r = genFreshReg(&state, last_use, 0);
+			}
+			srcs[j] = r;
+			last_use[r] = i;
+		}
+		// Destination, a WAW hazard writes the destination of the instruction d back, a WAR hazard one of its sources
+		dst = -1;
+		if (op != OP_ST) {
+			d = 1 + genRandomBelow(&state, hist_size - 1);
+			if (d <= i && genRandomBelow(&state, 100) < spec->waw && hist[(i - d) % hist_size][0] != -1) {
+				dst = hist[(i - d) % hist_size][0];
+			}
+			else if (d <= i && genRandomBelow(&state, 100) < spec->war && hist[(i - d) % hist_size][1] != -1) {
+				dst = hist[(i - d) % hist_size][1 + genRandomBelow(&state, 2)];
+				if (dst <= 0) { // No second source, or F0 which is never written
+					dst = hist[(i - d) % hist_size][1];
+				}
+				if (dst == 0) {
+					dst = genFreshReg(&state, last_use, 1);
+				}
+			}
+			else {
+				dst = genFreshReg(&state, last_use, 1);
+			}
+			last_use[dst] = i;
+		}
+
+		addr = 0;
+		if (op == OP_LD || op == OP_ST) {
+			if (recent_num > 0 && genRandomBelow(&state, 100) < spec->alias) {
+				addr = recent_addr[genRandomBelow(&state, recent_num < GEN_ALIAS_WINDOW ? recent_num : GEN_ALIAS_WINDOW)];
+			}
+			else {
+				addr = data_base + genRandomBelow(&state, addr_range);
+			}
+			if (data_base == 0 && (int)addr >= addr_range) { // An aliased address which is too close to this instruction
+				addr = genRandomBelow(&state, addr_range);
+			}
+			recent_addr[recent_num++ % GEN_ALIAS_WINDOW] = addr;
+		}
+
+		hist[i % hist_size][0] = dst;
+		hist[i % hist_size][1] = srcs[0];
+		hist[i % hist_size][2] = srcs[1];
+		if (op == OP_ST) {
+			words[i] = (op << 24) | (genRandomBelow(&state, REGS_NUM) << 20) | (srcs[0] << 12) | (int)addr;
+		}
+		else {
+			words[i] = (op << 24) | (dst << 20) | ((srcs[0] == -1 ? 0 : srcs[0]) << 16) | ((srcs[1] == -1 ? 0 : srcs[1]) << 12) | (int)addr;
+		}
+	}
+	words[spec->length] = HALT_INST;
+	if (data_base != 0) {
+		for (i = 0; i < spec->data_words; i++) {
+			value = (float)(1 + genRandomBelow(&state, 16));
+			words[data_base + i] = floatToSinglePre(value);
+		}
+	}
+	free(hist);
+}
+
+/*
+	Generates the program of the workload spec file into a memin file, text or binary by its name (see isBinaryImage).
+	Returns 1 on success.
+*/
+int generateWorkloadFile(char *spec_path, char *memin_path) {
+	Gen_spec spec;
+	Sim_mem mem;
+	int *words;
+	int i, n, res;
+
+	if (!parseGenSpec(spec_path, &spec)) {
+		return 0;
+	}
+	n = genImageWords(&spec);
+	words = (int*)malloc(n * sizeof(int));
+	if (words == NULL) {
+		printf("Fail to malloc the workload words\n");
+		return 0;
+	}
+	generateWorkload(&spec, words);
+	init_mem(&mem, 32);
+	for (i = 0; i < n; i++) {
+		memWrite(&mem, i, words[i], 0);
+	}
+	res = writeMemout(memin_path, &mem, 0);
+	free_mem(&mem);
+	free(words);
+	return res;
+}
+
+/*
+	Host throughput benchmark.
+	Each line of the benchmark file is a cfg path and a workload spec path (quoted like the batch manifest).
+	Every workload is generated in memory and simulated repeats times with its cfg, without any output file,
+	and the fastest run is reported: the simulated cycles per host second and the host nanoseconds per instruction.
+	The table has a line per benchmark and a total line, so two tables of the same benchmark file can be compared.
+*/
+int runBenchmark(char *bench_path, char *table_path, int repeats) {
+	FILE *bench, *table;
+	char line[2 * MAX_LINE_LENGTH];
+	char paths[2][MAX_LINE_LENGTH];
+	char *pos;
+	Run_cfg cfg;
+	Gen_spec spec;
+	Sim_ctx *ctx;
+	Sim_mem image;
+	int *words;
+	int i, n, r, cycles, insts, ok = 1, benches = 0;
+	double start, elapsed, best, total_sec = 0, total_cycles = 0, total_insts = 0;
+
+	bench = fopen(bench_path, "r");
+	if (bench == NULL) {
+		printf("couldn't open the benchmark file %s\n", bench_path);
+		return 0;
+	}
+	table = fopen(table_path, "w");
+	if (table == NULL) {
+		printf("couldn't open the table file %s\n", table_path);
+		fclose(bench);
+		return 0;
+	}
+	ctx = (Sim_ctx*)calloc(1, sizeof(Sim_ctx));
+	if (ctx == NULL) {
+		printf("Fail to calloc the simulation context\n");
+		fclose(bench);
+		fclose(table);
+		return 0;
+	}
+	if (repeats < 1) {
+		repeats = 1;
+	}
+	fprintf(table, "cfg workload insts cycles sec Mcycles/sec ns/inst\n");
+	while (fgets(line, sizeof(line), bench) != NULL) {
+		pos = line;
+		for (i = 0; i < 2 && readManifestPath(&pos, paths[i]); i++);
+		if (i == 0) { // Empty line
+			continue;
+		}
+		if (i < 2 || !parseCfg(paths[0], &cfg) || !parseGenSpec(paths[1], &spec)) {
+			if (i < 2) {
+				printf("benchmark line needs a cfg and a workload spec\n");
+			}
+			ok = 0;
+			continue;
+		}
+		n = genImageWords(&spec);
+		if (cfg.sim.mem_addr_bits < 32 && (unsigned int)n > 1u << cfg.sim.mem_addr_bits) {
+			printf("%s: the %d words of %s don't fit mem_addr_bits\n", paths[0], n, paths[1]);
+			ok = 0;
+			continue;
+		}
+		words = (int*)malloc(n * sizeof(int));
+		if (words == NULL) {
+			printf("Fail to malloc the workload words\n");
+			ok = 0;
+			break;
+		}
+		generateWorkload(&spec, words);
+		init_mem(&image, cfg.sim.mem_addr_bits);
+		for (i = 0; i < n; i++) {
+			memWrite(&image, i, words[i], 0);
+		}
+		free(words);
+
+		best = -1;
+		cycles = 0;
+		insts = 0;
+		for (r = 0; r < repeats; r++) {
+			init_unit_table(&ctx->fu, 1);
+			insertUnits(&ctx->fu, &cfg.sim);
+			initSimCtx(ctx, cfg.sim.queue_depth);
+			configureSimCtx(ctx, &cfg.sim);
+			memCopy(&ctx->mem, &image);
+			start = wallTime();
+			cycles = simulate(ctx, NULL, cfg.sim.event_driven, NULL, NULL);
+			elapsed = wallTime() - start;
+			insts = ctx->inst_num;
+			freeSimCtx(ctx);
+			free_mem(&ctx->mem);
+			if (best < 0 || elapsed < best) {
+				best = elapsed;
+			}
+		}
+		free_mem(&image);
+
+		fprintf(table, "%s %s %d %d %.6f %.3f %.1f\n", paths[0], paths[1], insts, cycles, best,
+			best > 0 ? cycles / best / 1e6 : 0.0, insts > 0 ? best * 1e9 / insts : 0.0);
+		total_sec += best;
+		total_cycles += cycles;
+		total_insts += insts;
+		benches++;
+	}
+	fprintf(table, "total %d %.0f %.0f %.6f %.3f %.1f\n", benches, total_insts, total_cycles, total_sec,
+		total_sec > 0 ? total_cycles / total_sec / 1e6 : 0.0, total_insts > 0 ? total_sec * 1e9 / total_insts : 0.0);
+	printf("%d benchmarks, %.0f instructions in %.3f sec, %.3f Mcycles/sec, %.1f ns/inst\n", benches, total_insts, total_sec,
+		total_sec > 0 ? total_cycles / total_sec / 1e6 : 0.0, total_insts > 0 ? total_sec * 1e9 / total_insts : 0.0);
+	free(ctx);
+	fclose(bench);
+	fclose(table);
+	return ok;
+}
+
+/*
+	Converts a memory image file (any memin format, see isBinaryImage) to a file of its words as floats, or back when to_mem is set.
+	The floats file has a float per line for every word of the full memory dump (see writeMemout), with 9 significant digits,
+	enough to get back the same bits. A nan loses its bits that way, so it is written with its word in hex ("nan 7FC00001").
+	Back to memory, a line is a word like in readMemin (a blank or bad line is 0), and the image is written like a full memout.
+	Returns 1 on success.
+*/
+int convertMemFloats(char *in_path, char *out_path, int to_mem, int legacy_float) {
+	FILE* in;
+	FILE* out;
+	char line[MAX_LINE_LENGTH];
+	Sim_mem mem;
+	Mem_page *page;
+	float *floats;
+	float f;
+	unsigned int pages, p, i, addr = 0, bits;
+	int word, fields, res;
+
+	init_mem(&mem, 32);
+	if (to_mem) {
+		in = fopen(in_path, "r");
+		if (in == NULL) {
+			printf("couldn't open the input file");
+			return 0;
+		}
+		while (fgets(line, MAX_LINE_LENGTH, in) != NULL) {
+			fields = sscanf(line, "%f %x", &f, &bits);
+			if (fields == 2 && isnan(f)) {
+				memWrite(&mem, addr, (int)bits, 0);
+			}
+			else if (fields >= 1) {
+				floatsToMem(&f, &word, 1, legacy_float);
+				memWrite(&mem, addr, word, 0);
+			}
+			addr++;
+			if (addr == 0) {
+				break;
+			}
+		}
+		fclose(in);
+		res = writeMemout(out_path, &mem, 0);
+		free_mem(&mem);
+		return res;
+	}
+
+	if (!readMemin(in_path, &mem)) {
+		free_mem(&mem);
+		return 0;
+	}
+	out = fopen(out_path, "w");
+	if (out == NULL) {
+		printf("couldn't open the output file");
+		free_mem(&mem);
+		return 0;
+	}
+	floats = (float*)calloc(PAGE_WORDS, sizeof(float));
+	if (floats == NULL) {
+		printf("Fail to calloc the floats\n");
+		fclose(out);
+		free_mem(&mem);
+		return 0;
+	}
+	pages = memDumpPages(&mem);
+	for (p = 0; p < pages; p++) {
+		page = memPage(&mem, p * PAGE_WORDS);
+		if (page == NULL) {
+			for (i = 0; i < PAGE_WORDS; i++) {
+				fprintf(out, "0\n");
+			}
+			continue;
+		}
+		memToFloats(page->words, floats, PAGE_WORDS, legacy_float);
+		for (i = 0; i < PAGE_WORDS; i++) {
+			if (isnan(floats[i])) {
+				fprintf(out, "nan %.8X\n", page->words[i]);
+			}
+			else {
+				fprintf(out, "%.9g\n", floats[i]);
+			}
+		}
+	}
+	fclose(out);
+	free(floats);
+	free_mem(&mem);
+	return 1;
+}
+
+/*
+	Converts a binary trace file to the text trace, the trace kind is taken from its magic.
+	Returns 1 on success.
+*/
+int convertTrace(char *in_path, char *out_path) {
+	FILE* in;
+	FILE* out;
+	char magic[4];
+	char row[BUF_SIZE];
+	Trace_inst_rec inst_rec;
+	Trace_unit_rec unit_rec;
+	Trace_unit_rec *active, *grown;
+	int i, j, cc = 0, more, active_num = 0, size = 16, ok = 1;
+
+	in = fopen(in_path, "rb");
+	if (in == NULL) {
+		printf("couldn't open the binary trace file");
+		return 0;
+	}
+	if (fread(magic, 1, 4, in) != 4 || (memcmp(magic, "SBTI", 4) != 0 && memcmp(magic, "SBTU", 4) != 0)) {
+		printf("%s is not a binary trace file\n", in_path);
+		fclose(in);
+		return 0;
+	}
+	out = fopen(out_path, "w");
+	if (out == NULL) {
+		printf("couldn't open the text trace file");
+		fclose(in);
+		return 0;
+	}
+	if (magic[3] == 'I') {
+		while (fread(&inst_rec, sizeof(inst_rec), 1, in) == 1) {
+			formatTraceInst(row, &inst_rec);
+			fputs(row, out);
+		}
+	}
+	else {
+		// A record covers a run of cycles, so the rows are printed cycle by cycle from the records active at that cycle.
+		// The records are ordered by their first cycle, and the active ones are kept in file order which is the unit order.
+		active = (Trace_unit_rec*)malloc(size * sizeof(Trace_unit_rec));
+		if (active == NULL) {
+			printf("Fail to malloc the trace records\n");
+			fclose(in);
+			fclose(out);
+			return 0;
+		}
+		more = fread(&unit_rec, sizeof(unit_rec), 1, in) == 1;
+		while (ok && (more || active_num > 0)) {
+			if (active_num == 0 && more) {
+				cc = unit_rec.cc;
+			}
+			while (more && unit_rec.cc == cc) {
+				if (active_num == size) {
+					grown = (Trace_unit_rec*)realloc(active, 2 * size * sizeof(Trace_unit_rec));
+					if (grown == NULL) {
+						printf("Fail to realloc the trace records\n");
+						ok = 0;
+						break;
+					}
+					active = grown;
+					size *= 2;
+				}
+				active[active_num++] = unit_rec;
+				more = fread(&unit_rec, sizeof(unit_rec), 1, in) == 1;
+			}
+			for (i = 0, j = 0; i < active_num; i++) {
+				formatTraceUnit(row, &active[i]);
+				fprintf(out, "%d%s", cc, row);
+				if (cc + 1 < active[i].cc + active[i].cycles) {
+					active[j++] = active[i];
+				}
+			}
+			active_num = j;
+			cc++;
+		}
+		free(active);
+	}
+	fclose(in);
+	fclose(out);
+	return ok;
+}
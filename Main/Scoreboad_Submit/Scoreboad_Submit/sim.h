@@ -0,0 +1,149 @@
+#ifndef SIM_H
+#define SIM_H
+
+/*
+	Scoreboard simulator library.
+	A simulator is created from a config and a memory image in memory, stepped or run to halt, and queried for its
+	registers, memory, instructions timestamps and units state, without any file.
+	The file based runs of the command line (sim.c) are built on the same simulation.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opcodes, which are also the unit types
+#define OP_LD   0
+#define OP_ST   1
+#define OP_ADD  2
+#define OP_SUB  3
+#define OP_MULT 4
+#define OP_DIV  5
+#define OP_HALT 6
+
+// Replacement policies of the data cache
+#define CACHE_LRU    0
+#define CACHE_FIFO   1
+#define CACHE_RANDOM 2
+
+typedef struct {
+	// Number of units and delay of each unit type, indexed by opcode.
+	int units[6];
+	int delays[6];
+
+	// Address space size in bits (12..32)
+	int mem_addr_bits;
+
+	// Flags, same as the cfg keys mem_base_addressing, legacy_float and event_driven
+	int base_addressing;
+	int legacy_float;
+	int event_driven;
+
+	// Flag to time the instructions by Tomasulo's algorithm, with register renaming, instead of the scoreboard. Same as the cfg key tomasulo.
+	int tomasulo;
+
+	// Flag to keep the LD/ST in order per address by a memory dependence table, with store to load forwarding.
+	// Same as the cfg key mem_disambiguation.
+	int mem_disambiguation;
+
+	// Instructions fetched and issued per clock cycle, same as the cfg keys fetch_width and issue_width
+	int fetch_width;
+	int issue_width;
+
+	// Number of instructions the queue holds from fetch to retire, same as the cfg key queue_depth
+	int queue_depth;
+
+	// Pipelined flag and initiation interval (cycles between starts) of each unit type, same as the cfg keys *_pipelined and *_ii.
+	// A pipelined unit has several instructions in flight, see simUnitState.
+	int pipelined[6];
+	int ii[6];
+
+	// Data cache between the LD/ST units and the memory, same as the cfg keys cache_*. cache_size 0 is no cache.
+	// Sizes are in memory words, a cache_miss_delay of 0 is the LD/ST delay.
+	int cache_size;
+	int cache_line;
+	int cache_ways;
+	int cache_policy;
+	int cache_hit_delay;
+	int cache_miss_delay;
+} Sim_config;
+
+// Timestamps of an instruction, the clock cycles of its stages. Also the record layout of a binary traceinst.
+typedef struct {
+	unsigned int inst;
+	int opcode;
+	int unit_index;
+	int issue;
+	int read;
+	int exec;
+	int write;
+} Sim_inst_times;
+
+// State of a function unit, like a traceunit row.
+typedef struct {
+	int busy;
+	int f_i;
+	int f_j;
+	int f_k;
+	// Type and index of the units producing the sources, -1 if none
+	int q_j_type;
+	int q_j_idx;
+	int q_k_type;
+	int q_k_idx;
+	int r_j;
+	int r_k;
+	// Remaining execution cycles
+	int remain;
+} Sim_unit_state;
+
+typedef struct Sim Sim;
+
+// Sets the config to the given units numbers and delays of every type, a 12 bits address space, single issue,
+// a 16 instructions queue, no pipelined units, no cache and no flags.
+void simDefaultConfig(Sim_config *cfg, int units, int delay);
+
+// Reads the config of a cfg file. Returns 0 if a unit type is missing.
+int simReadConfig(char *cfg_path, Sim_config *cfg);
+
+// Creates a simulator of the memory image, words from address 0 (the rest is 0).
+// Returns NULL if the config is invalid, a value out of the range of its cfg key or a cache that doesn't split into sets.
+Sim *simCreate(const Sim_config *cfg, const int *mem, unsigned int words);
+void simDestroy(Sim *sim);
+
+// Simulates up to cycles clock cycles, one at a time. Returns 0 once the simulation ended.
+int simStep(Sim *sim, int cycles);
+
+// Simulates until halt, skipping quiet cycles if the config is event driven. Returns the total clock cycles.
+int simRunToHalt(Sim *sim);
+
+// Number of clock cycles simulated so far.
+int simCycles(Sim *sim);
+
+float simRegister(Sim *sim, int reg);
+int simMemory(Sim *sim, unsigned int addr);
+
+// Timestamps of the retired instructions in issue order, their number is returned through num.
+const Sim_inst_times *simInstTimes(Sim *sim, int *num);
+
+// State of the index unit of the type. Returns 0 if there is no such unit.
+// The in flight instructions of a pipelined unit are its slots, index + slot * units of the type.
+int simUnitState(Sim *sim, int type, int index, Sim_unit_state *state);
+
+/*
+	File based runs of the command line, see main.c.
+	Each returns 1 on success, errors are printed.
+*/
+int runSimulation(char **paths);
+int runBatch(char *manifest_path, int workers_num);
+int runSweep(char *cfg_path, char *memin_path, char *table_path, int workers_num);
+int generateWorkloadFile(char *spec_path, char *memin_path);
+int runBenchmark(char *bench_path, char *table_path, int repeats);
+int convertMemFloats(char *in_path, char *out_path, int to_mem, int legacy_float);
+int convertMemImage(char *in_path, char *out_path);
+int convertTrace(char *in_path, char *out_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif